@@ -23,8 +23,26 @@ const char * AbstractCommand::getCommandLine() {
     return commandLine;
 }
 
-void AbstractCommand::setRunTimeout(unsigned long timeout) {
+bool AbstractCommand::setRunTimeout(unsigned long timeout) {
+    if (timeout > Deadline::MAX_TIMEOUT / 1000) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->printf("%s: run timeout %lu ms out of range, at most %lu ms\r\n", getName(), timeout,
+                         static_cast<unsigned long>(Deadline::MAX_TIMEOUT / 1000));
+        return false;
+    }
+    runTimeout = static_cast<uint32_t>(timeout * 1000);
+    return true;
+}
+
+bool AbstractCommand::setRunTimeoutMicros(const uint32_t timeout) {
+    if (timeout > Deadline::MAX_TIMEOUT) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->printf("%s: run timeout %lu us out of range, at most %lu us\r\n", getName(),
+                         static_cast<unsigned long>(timeout), static_cast<unsigned long>(Deadline::MAX_TIMEOUT));
+        return false;
+    }
     runTimeout = timeout;
+    return true;
 }
 
 void AbstractCommand::setQuiet(bool quiet) {
@@ -40,18 +58,43 @@ void AbstractCommand::setContext(CommandContextInterface *cmdContext) {
 }
 
 bool AbstractCommand::write(const char *str) {
-    if (ctx == nullptr) return false;
-    return ctx->cmdOutputBuffer.write(str);
+    return write(str, strlen(str));
 }
 
 bool AbstractCommand::write(const void *in, size_t strlen) {
     if (ctx == nullptr) return false;
-    return ctx->cmdOutputBuffer.write(static_cast<const uint8_t *>(in), strlen);
+    auto data = static_cast<const uint8_t *>(in);
+
+    // Write as much as possible directly into the transport
+    const auto span = ctx->reserveOutput();
+    const auto direct = std::min(strlen, span.size);
+    if (direct > 0) {
+        memcpy(span.ptr, data, direct);
+        ctx->commitOutput(direct);
+        data += direct;
+        strlen -= direct;
+    }
+
+    // Buffer the rest until the transport has drained
+    return strlen == 0 || ctx->cmdOutputBuffer.write(data, strlen);
 }
 
 bool AbstractCommand::printf(const char *format, ...) {
     if (ctx == nullptr) return false;
     va_list args;
+
+    // Format directly into the transport, if the result fits
+    const auto span = ctx->reserveOutput();
+    if (span.size > 0) {
+        va_start(args, format);
+        const auto len = vsnprintf(span.ptr, span.size, format, args);
+        va_end(args);
+        if (len >= 0 && static_cast<size_t>(len) < span.size) {
+            ctx->commitOutput(len);
+            return true;
+        }
+    }
+
     va_start(args, format);
     auto ret = ctx->cmdOutputBuffer.vprintf(format, args);
     va_end(args);
@@ -62,9 +105,22 @@ CommandContextInterface::cmdOutputBufferClass * AbstractCommand::out() {
     return &ctx->cmdOutputBuffer;
 }
 
+size_t AbstractCommand::outputAvailable() {
+    if (ctx == nullptr) return 0;
+    return ctx->outputAvailable();
+}
+
+bool AbstractCommand::hasOutputSpace(const size_t len) {
+    outputWait = outputAvailable() >= len ? 0 : len;
+    return outputWait == 0;
+}
+
 void AbstractCommand::setParam(int argc, const char * const *argv) {
     this->argc = argc;
     this->argv = argv;
+    if (argSpecCount > 0) {
+        args.parse(argSpecs, argSpecCount, argc, argv);
+    }
 }
 
 void AbstractCommand::setParam(char paramName, const char *paramString) {
@@ -8,8 +8,10 @@
 
 #include "CommandContext.hpp"
 #include "CommandInterface.hpp"
+#include "Arguments.hpp"
 #include "main.hpp"
 #include "Loggable.hpp"
+#include "Log.hpp"
 
 namespace Stm32Shell::Command {
     class AbstractCommand : public CommandInterface, public Stm32ItmLogger::Loggable {
@@ -19,57 +21,72 @@ namespace Stm32Shell::Command {
         AbstractCommand();
 
         preFlightCheckReturn preFlightCheck() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::preFlightCheck()");
             return preFlightCheckReturn::READY;
         };
 
         initReturn init() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::init()");
             return initReturn::READY;
         };
 
         runReturn run() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::run()");
             return runReturn::FINISHED;
         };
 
         cleanupReturn cleanup() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::cleanup()");
             return cleanupReturn::OK;
         };
 
         void terminate() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::terminate()");
         };
 
         void recycle() override {
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->print(getName());
-            log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
                     ->println("::recycle()");
             setCommandLine("", 0);
             argc = 0;
             argv = nullptr;
+            args.clear();
+            outputWait = 0;
         };
 
 
+        /**
+         * @brief Stores the tokens of the command line.
+         *
+         * If the command has declared its arguments with setArgSpecs(), they are
+         * parsed into args at the same time.
+         */
         virtual void setParam(int argc, const char *const *argv);
 
+        const char *getArgumentError() override { return args.getError(); }
+
+        /**
+         * @brief Converts a parameter with strtol() and strtod() and passes it to both overloads below.
+         *
+         * Kept for commands without an argument spec. Commands with a spec read the typed values from args.
+         */
         virtual void setParam(char paramName, const char *paramString);
 
         virtual void setParam(char paramName, long paramLong) {
@@ -85,24 +102,63 @@ namespace Stm32Shell::Command {
 
         virtual const char *getName() { return "AbstractCommand"; }
 
-        void setRunTimeout(unsigned long timeout);
+        /**
+         * @brief Sets the time the run phase may take.
+         *
+         * @param timeout Timeout [ms], 0 for no timeout. At most Deadline::MAX_TIMEOUT / 1000,
+         *                about 35.8 minutes.
+         * @return false if the timeout is out of range, the previous timeout is kept.
+         */
+        bool setRunTimeout(unsigned long timeout);
+
+        /**
+         * @brief Sets the time the run phase may take, with microsecond resolution.
+         *
+         * @param timeout Timeout [us], 0 for no timeout. At most Deadline::MAX_TIMEOUT.
+         * @return false if the timeout is out of range, the previous timeout is kept.
+         */
+        bool setRunTimeoutMicros(uint32_t timeout);
 
         void setQuiet(bool quiet = true);
 
         bool isQuietRun() const;
 
-        CommandContextInterface *getCommandContext() { return ctx; }
+        CommandContextInterface *getCommandContext() override { return ctx; }
 
-        virtual AbstractCommand *factory() { return new AbstractCommand; }
+        /**
+         * @brief Creates a per-session instance of the command.
+         *
+         * Derived commands should override this and return a new instance of their
+         * own type. The default returns nullptr, so the registered instance is shared.
+         */
+        AbstractCommand *factory() override { return nullptr; }
+
+        /**
+         * @brief Gives a per-session instance back.
+         *
+         * The default deletes the instance, matching a factory() that uses new.
+         * Use PooledCommand to get instances from a fixed pool instead of the heap.
+         */
+        void release() override { delete this; }
 
         bool isCmdSync() override {
             return isSync;
         }
 
+        /** @return Run timeout [ms], rounded up so a sub-millisecond timeout is not 0. */
         uint32_t getRunTimeout() override {
+            return runTimeout / 1000 + (runTimeout % 1000 != 0 ? 1 : 0);
+        }
+
+        uint32_t getRunTimeoutMicros() override {
             return runTimeout;
         }
 
+        /** @return The output space of the last failed call to hasOutputSpace(). */
+        wait_t getWait() override {
+            return {outputWait, {}};
+        }
+
     protected:
         /**
          * @brief This virtual function is called when the run timeout occurs.
@@ -152,6 +208,44 @@ namespace Stm32Shell::Command {
 
         CommandContextInterface::cmdOutputBufferClass *out();
 
+        /**
+         * @brief Returns the number of bytes that can be written without losing output.
+         *
+         * A command with more output than that should return runReturn::RUNNING and
+         * continue when it is called again, instead of waiting inside run(). See
+         * hasOutputSpace(), which also reports the wait to the session.
+         */
+        size_t outputAvailable();
+
+        /**
+         * @brief Checks for output space, and waits for it if it is not there.
+         *
+         * If it returns false, return runReturn::RUNNING. The command is run again
+         * when the transport has made room, instead of being polled meanwhile.
+         *
+         * @param len Number of bytes to write next.
+         * @return true if len bytes can be written without losing output.
+         */
+        bool hasOutputSpace(size_t len);
+
+        /**
+         * @brief Declares the arguments of the command.
+         *
+         * Usually called from the constructor with a static array.
+         *
+         * @param specs Declaration of the arguments, must outlive the command.
+         * @param count Number of declarations.
+         */
+        void setArgSpecs(const Arguments::spec_t *specs, const size_t count) {
+            argSpecs = specs;
+            argSpecCount = count;
+        }
+
+        template<size_t N>
+        void setArgSpecs(const Arguments::spec_t (&specs)[N]) {
+            setArgSpecs(specs, N);
+        }
+
     protected:
         /** true: the command is executed immediately and synchronous. */
         bool isSync = false;
@@ -160,13 +254,21 @@ namespace Stm32Shell::Command {
         int argc = 0;
         const char *const *argv = nullptr;
 
+        /** Typed arguments, parsed by setParam() if setArgSpecs() has been called */
+        Arguments args;
+
     private:
+        const Arguments::spec_t *argSpecs = nullptr;
+        size_t argSpecCount = 0;
+
         CommandContextInterface *ctx{};
 
         void setContext(CommandContextInterface *ctx) override;
 
-        /** Timeout [ms] in which the command must be completed. */
-        unsigned long runTimeout = 0;
+        /** Timeout [us] in which the command must be completed. */
+        uint32_t runTimeout = 0;
+        /** Output space [bytes] the command waits for, 0 for none. */
+        size_t outputWait = 0;
         /** Quiet run: no "ok" after run */
         bool quietRun = false;
         /** Used to delay debug output */
@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Arguments.hpp"
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+
+using namespace Stm32Shell::Command;
+
+namespace {
+    bool isDigit(const char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    char toUpper(const char c) {
+        return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    int hexValue(const char c) {
+        if (isDigit(c)) return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    /**
+     * @brief Reads digits with an optional fraction as mantissa * 10^exp10.
+     *
+     * Digits beyond the precision of the mantissa only scale the exponent.
+     * Advances p behind the last digit.
+     *
+     * @return false if there is no digit.
+     */
+    bool parseDecimal(const char *&p, uint32_t &mantissa, int &exp10) {
+        constexpr uint32_t mantissaLimit = 100000000;
+        bool digits = false;
+        mantissa = 0;
+        exp10 = 0;
+        for (; isDigit(*p); p++) {
+            digits = true;
+            if (mantissa < mantissaLimit) {
+                mantissa = mantissa * 10 + (*p - '0');
+            } else {
+                exp10++;
+            }
+        }
+        if (*p == '.') {
+            for (p++; isDigit(*p); p++) {
+                digits = true;
+                if (mantissa < mantissaLimit) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    exp10--;
+                }
+            }
+        }
+        return digits;
+    }
+}
+
+bool Arguments::parseInt(const char *str, int32_t &value) {
+    const char *p = str;
+    bool negative = false;
+    if (*p == '+' || *p == '-') negative = *p++ == '-';
+
+    const uint64_t limit = negative ? 0x80000000ULL : 0x7fffffffULL;
+    uint64_t result = 0;
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+        if (hexValue(*p) < 0) return false;
+        for (; hexValue(*p) >= 0; p++) {
+            result = result * 16 + hexValue(*p);
+            if (result > limit) return false;
+        }
+    } else {
+        if (!isDigit(*p)) return false;
+        for (; isDigit(*p); p++) {
+            result = result * 10 + (*p - '0');
+            if (result > limit) return false;
+        }
+    }
+    if (*p != '\0') return false;
+
+    value = negative
+                ? static_cast<int32_t>(-static_cast<int64_t>(result))
+                : static_cast<int32_t>(result);
+    return true;
+}
+
+bool Arguments::parseFloat(const char *str, float &value) {
+    static constexpr float pow10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    constexpr int pow10Max = sizeof pow10 / sizeof pow10[0] - 1;
+
+    const char *p = str;
+    bool negative = false;
+    if (*p == '+' || *p == '-') negative = *p++ == '-';
+
+    uint32_t mantissa;
+    int exp10;
+    if (!parseDecimal(p, mantissa, exp10)) return false;
+
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        bool expNegative = false;
+        if (*p == '+' || *p == '-') expNegative = *p++ == '-';
+        if (!isDigit(*p)) return false;
+        int exponent = 0;
+        for (; isDigit(*p); p++) {
+            if (exponent < 100) exponent = exponent * 10 + (*p - '0');
+        }
+        exp10 += expNegative ? -exponent : exponent;
+    }
+    if (*p != '\0') return false;
+
+    auto result = static_cast<float>(mantissa);
+    while (exp10 > 0 && result != 0.0f) {
+        const int step = exp10 < pow10Max ? exp10 : pow10Max;
+        result *= pow10[step];
+        exp10 -= step;
+    }
+    while (exp10 < 0 && result != 0.0f) {
+        const int step = -exp10 < pow10Max ? -exp10 : pow10Max;
+        result /= pow10[step];
+        exp10 += step;
+    }
+    // Overflow to infinity, or underflow of a non-zero number to zero
+    if (result > FLT_MAX || (result == 0.0f && mantissa != 0)) return false;
+
+    value = negative ? -result : result;
+    return true;
+}
+
+bool Arguments::parseDuration(const char *str, uint32_t &us) {
+    const char *p = str;
+    uint32_t mantissa;
+    int exp10;
+    if (!parseDecimal(p, mantissa, exp10)) return false;
+
+    uint64_t unit;
+    if (*p == '\0' || strcmp(p, "ms") == 0) {
+        unit = 1000;
+    } else if (strcmp(p, "us") == 0) {
+        unit = 1;
+    } else if (strcmp(p, "s") == 0) {
+        unit = 1000000;
+    } else if (strcmp(p, "m") == 0) {
+        unit = 60000000;
+    } else {
+        return false;
+    }
+
+    uint64_t result = mantissa * unit;
+    for (; exp10 > 0; exp10--) {
+        result *= 10;
+        if (result > UINT32_MAX) return false;
+    }
+    for (; exp10 < 0 && result != 0; exp10++) {
+        result /= 10;
+    }
+    if (result > UINT32_MAX) return false;
+
+    us = static_cast<uint32_t>(result);
+    return true;
+}
+
+int Arguments::parseEnum(const char *str, const char *const *words, const uint8_t wordCount) {
+    for (int i = 0; i < wordCount; i++) {
+        const char *a = str;
+        const char *b = words[i];
+        while (*a != '\0' && toUpper(*a) == toUpper(*b)) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') return i;
+    }
+    return -1;
+}
+
+bool Arguments::parse(const spec_t *argSpecs, const size_t count, const int argc, const char *const *argv) {
+    clear();
+    specs = argSpecs;
+    specCount = count < LIBSMART_STM32SHELL_ARGUMENTS_MAX ? count : LIBSMART_STM32SHELL_ARGUMENTS_MAX;
+
+    size_t nextPositional = 0;
+    for (int a = 1; a < argc; a++) {
+        const char *token = argv[a];
+
+        // Lettered argument?
+        size_t idx = specCount;
+        const char *valueStr = token + 1;
+        if (token[0] != '\0') {
+            for (size_t i = 0; i < specCount; i++) {
+                if (!specs[i].positional && toUpper(specs[i].letter) == toUpper(token[0])) {
+                    idx = i;
+                    break;
+                }
+            }
+        }
+
+        // Otherwise the next positional argument
+        if (idx == specCount) {
+            while (nextPositional < specCount && !specs[nextPositional].positional) nextPositional++;
+            if (nextPositional == specCount) return fail("unexpected argument '%s'", token);
+            idx = nextPositional++;
+            valueStr = token;
+        }
+
+        auto &value = values[idx];
+        if (value.present) return fail("duplicate argument '%s'", token);
+
+        bool ok = false;
+        switch (specs[idx].valueType) {
+            case type::FLAG:
+                ok = *valueStr == '\0';
+                break;
+            case type::INT:
+                ok = parseInt(valueStr, value.asInt);
+                break;
+            case type::FLOAT:
+                ok = parseFloat(valueStr, value.asFloat);
+                break;
+            case type::ENUM:
+                value.asEnum = parseEnum(valueStr, specs[idx].words, specs[idx].wordCount);
+                ok = value.asEnum >= 0;
+                break;
+            case type::DURATION:
+                ok = parseDuration(valueStr, value.asDuration);
+                break;
+        }
+        if (!ok) return fail("invalid argument '%s'", token);
+        value.present = true;
+    }
+
+    for (size_t i = 0; i < specCount; i++) {
+        if (specs[i].required && !values[i].present) {
+            const char letter[2] = {specs[i].letter, '\0'};
+            return fail("missing argument '%s'", letter);
+        }
+    }
+    return true;
+}
+
+void Arguments::clear() {
+    specs = nullptr;
+    specCount = 0;
+    memset(values, 0, sizeof values);
+    error[0] = '\0';
+}
+
+bool Arguments::has(const char letter) const {
+    return find(letter) != nullptr;
+}
+
+int32_t Arguments::getInt(const char letter, const int32_t def) const {
+    const auto *value = find(letter);
+    return value == nullptr ? def : value->asInt;
+}
+
+float Arguments::getFloat(const char letter, const float def) const {
+    const auto *value = find(letter);
+    return value == nullptr ? def : value->asFloat;
+}
+
+uint32_t Arguments::getDuration(const char letter, const uint32_t def) const {
+    const auto *value = find(letter);
+    return value == nullptr ? def : value->asDuration;
+}
+
+int Arguments::getEnum(const char letter, const int def) const {
+    const auto *value = find(letter);
+    return value == nullptr ? def : value->asEnum;
+}
+
+const Arguments::value_t *Arguments::find(const char letter) const {
+    for (size_t i = 0; i < specCount; i++) {
+        if (toUpper(specs[i].letter) == toUpper(letter)) {
+            return values[i].present ? &values[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool Arguments::fail(const char *format, const char *what) {
+    snprintf(error, sizeof error, format, what);
+    return false;
+}
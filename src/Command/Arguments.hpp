@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_ARGUMENTS_HPP
+#define LIBSMART_STM32SHELL_COMMAND_ARGUMENTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/** Maximum number of arguments a command can declare */
+#ifndef LIBSMART_STM32SHELL_ARGUMENTS_MAX
+#define LIBSMART_STM32SHELL_ARGUMENTS_MAX 8
+#endif
+
+/** Size of the buffer for the parse error message */
+#ifndef LIBSMART_STM32SHELL_ARGUMENTS_ERROR_LEN
+#define LIBSMART_STM32SHELL_ARGUMENTS_ERROR_LEN 48
+#endif
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Typed arguments of a command, parsed against a declarative spec.
+     *
+     * A command declares its arguments as an array of spec_t. The arguments
+     * are parsed once, when the command line is handed to the command, and
+     * stored as typed values. run() then reads them without converting again.
+     *
+     * Each argument is identified by a letter. A lettered argument is given
+     * G-code style, the letter immediately followed by the value ("X10.5",
+     * "F3000", "T500ms"); a FLAG is the letter alone. Letters are case
+     * insensitive. A positional argument is matched by its position among the
+     * tokens that do not start with a lettered argument's letter.
+     *
+     * The number parsers are locale independent and do not allocate.
+     */
+    class Arguments {
+    public:
+        using u_type = enum class type : uint8_t {
+            FLAG,       ///< Letter without value, e.g. "X"
+            INT,        ///< Decimal or 0x hexadecimal integer, e.g. "S-12", "P0x1f"
+            FLOAT,      ///< Decimal number with optional fraction and exponent, e.g. "X10.5"
+            ENUM,       ///< One of a list of words, e.g. "on"
+            DURATION    ///< Number with unit us, ms, s or m, default ms, e.g. "T1.5s"
+        };
+
+        /**
+         * @brief Declaration of one argument.
+         */
+        struct spec_t {
+            char letter;                            ///< Letter identifying the argument
+            type valueType;                         ///< Type of the value
+            bool positional = false;                ///< true: matched by position instead of letter
+            bool required = false;                  ///< true: parsing fails if the argument is missing
+            const char *const *words = nullptr;     ///< Words of an ENUM
+            uint8_t wordCount = 0;                  ///< Number of words of an ENUM
+        };
+
+        /**
+         * @brief Parses the arguments of a command line.
+         *
+         * @param argSpecs Declaration of the arguments.
+         * @param count    Number of declarations, at most LIBSMART_STM32SHELL_ARGUMENTS_MAX.
+         * @param argc     Number of tokens.
+         * @param argv     Tokens, argv[0] is the command name.
+         * @return true on success, otherwise getError() describes the problem.
+         */
+        bool parse(const spec_t *argSpecs, size_t count, int argc, const char *const *argv);
+
+        /**
+         * @brief Forgets all values and errors.
+         */
+        void clear();
+
+        /**
+         * @return Error message of the last parse(), or nullptr if there was no error.
+         */
+        const char *getError() const { return error[0] == '\0' ? nullptr : error; }
+
+        /** @return true if the argument was given. */
+        bool has(char letter) const;
+
+        /** @return Value of an INT argument, or def if it was not given. */
+        int32_t getInt(char letter, int32_t def = 0) const;
+
+        /** @return Value of a FLOAT argument, or def if it was not given. */
+        float getFloat(char letter, float def = 0.0f) const;
+
+        /** @return Value of a DURATION argument in microseconds, or def if it was not given. */
+        uint32_t getDuration(char letter, uint32_t def = 0) const;
+
+        /** @return Index of the word of an ENUM argument, or def if it was not given. */
+        int getEnum(char letter, int def = -1) const;
+
+        /**
+         * @brief Parses a decimal or 0x hexadecimal integer with optional sign.
+         *
+         * @return false if str is not a complete integer or out of range.
+         */
+        static bool parseInt(const char *str, int32_t &value);
+
+        /**
+         * @brief Parses a decimal number with optional sign, fraction and exponent.
+         *
+         * @return false if str is not a complete number or out of the range of float.
+         */
+        static bool parseFloat(const char *str, float &value);
+
+        /**
+         * @brief Parses a non-negative duration with unit us, ms, s or m.
+         *
+         * A number without unit is taken as milliseconds.
+         *
+         * @param us Duration in microseconds.
+         * @return false if str is not a complete duration or out of range.
+         */
+        static bool parseDuration(const char *str, uint32_t &us);
+
+        /**
+         * @brief Looks up a word, case insensitive.
+         *
+         * @return Index of the word, or -1 if it is not in the list.
+         */
+        static int parseEnum(const char *str, const char *const *words, uint8_t wordCount);
+
+    private:
+        struct value_t {
+            bool present;
+
+            union {
+                int32_t asInt;
+                float asFloat;
+                uint32_t asDuration;
+                int asEnum;
+            };
+        };
+
+        const spec_t *specs = nullptr;
+        size_t specCount = 0;
+        value_t values[LIBSMART_STM32SHELL_ARGUMENTS_MAX] = {};
+        char error[LIBSMART_STM32SHELL_ARGUMENTS_ERROR_LEN] = {};
+
+        const value_t *find(char letter) const;
+
+        bool fail(const char *format, const char *what);
+    };
+}
+
+#endif
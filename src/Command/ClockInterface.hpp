@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_CLOCKINTERFACE_HPP
+#define LIBSMART_STM32SHELL_COMMAND_CLOCKINTERFACE_HPP
+
+#include <cstdint>
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Monotonic clock with microsecond resolution.
+     *
+     * The time wraps around at 2^32 us (about 71 minutes). Durations are
+     * computed as unsigned difference and deadlines are compared with
+     * Deadline, both are correct across the wrap for intervals below half the
+     * period.
+     */
+    class ClockInterface {
+    public:
+        virtual ~ClockInterface() = default;
+
+        /** @return Current time [us]. */
+        virtual uint32_t micros() = 0;
+
+        /** @return Time [us] elapsed since start, a value returned by micros(). */
+        uint32_t since(const uint32_t start) {
+            return micros() - start;
+        }
+    };
+
+
+    /**
+     * @brief A point in time at which something expires.
+     */
+    class Deadline {
+    public:
+        /** Longest timeout [us] a deadline can represent, about 35.8 minutes. */
+        static constexpr uint32_t MAX_TIMEOUT = INT32_MAX;
+
+        /**
+         * @brief Arms the deadline.
+         *
+         * @param now     Current time [us].
+         * @param timeout Time [us] from now until the deadline, at most MAX_TIMEOUT.
+         */
+        void set(const uint32_t now, const uint32_t timeout) {
+            at = now + timeout;
+            armed = true;
+        }
+
+        /** @brief Disarms the deadline, it never expires. */
+        void clear() {
+            armed = false;
+        }
+
+        /** @return true if the deadline has been set. */
+        bool isArmed() const {
+            return armed;
+        }
+
+        /**
+         * @param now Current time [us].
+         * @return true if the deadline is armed and has been reached.
+         */
+        bool hasExpired(const uint32_t now) const {
+            return armed && static_cast<int32_t>(now - at) >= 0;
+        }
+
+        /**
+         * @param now Current time [us].
+         * @return Time [us] left until the deadline, 0 if expired or not armed.
+         */
+        uint32_t remaining(const uint32_t now) const {
+            return armed && static_cast<int32_t>(at - now) > 0 ? at - now : 0;
+        }
+
+    private:
+        uint32_t at = 0;
+        bool armed = false;
+    };
+}
+
+#endif
@@ -4,8 +4,10 @@
  */
 
 #include "CommandContext.hpp"
+#include <algorithm>
 #include "Helper.hpp"
 #include "AbstractCommand.hpp"
+#include "Log.hpp"
 
 using namespace Stm32Shell::Command;
 AbstractCommand::preFlightCheckReturn preFlightCheckResult = AbstractCommand::preFlightCheckReturn::UNDEF;
@@ -25,6 +27,7 @@ bool CommandContext::hasError() {
         case cmdStates::RUN_DONE:
             return false;
 
+        case cmdStates::ARGUMENT_ERROR:
         case cmdStates::PREFLIGHTCHECK_ERROR:
         case cmdStates::INIT_ERROR:
         case cmdStates::RUN_TIMEOUT:
@@ -40,13 +43,26 @@ void CommandContext::do_preFlightCheck() {
     if (hasError() || mustRecycle) return;
     if (cmdState != cmdStates::UNDEF) return;
     cmdState = cmdStates::PREFLIGHTCHECK;
-    preFlightCheckResult = cmd->preFlightCheck();
+    if (metrics != nullptr) metrics->countInvocation();
+
+    // Invalid arguments are reported before the command sees them
+    if (const char *argumentError = cmd->getArgumentError(); argumentError != nullptr) {
+        cmdState = cmdStates::ARGUMENT_ERROR;
+        if (textStatus) {
+            cmdOutputBuffer.print("ERROR: ");
+            cmdOutputBuffer.println(argumentError);
+        }
+        mustRecycle = true;
+        return;
+    }
+
+    preFlightCheckResult = measure(CommandMetrics::phase::PREFLIGHTCHECK, [this] { return cmd->preFlightCheck(); });
 
     if (preFlightCheckResult == AbstractCommand::preFlightCheckReturn::READY) {
         cmdState = cmdStates::PREFLIGHTCHECK_DONE;
     } else {
         cmdState = cmdStates::PREFLIGHTCHECK_ERROR;
-        cmdOutputBuffer.println("ERROR: preFlightCheck failed");
+        if (textStatus) cmdOutputBuffer.println("ERROR: preFlightCheck failed");
         mustRecycle = true;
     }
 }
@@ -55,12 +71,12 @@ void CommandContext::do_init() {
     if (hasError() || mustRecycle) return;
     if (cmdState != cmdStates::PREFLIGHTCHECK_DONE) return;
     cmdState = cmdStates::INIT;
-    initResult = cmd->init();
+    initResult = measure(CommandMetrics::phase::INIT, [this] { return cmd->init(); });
     cmdState = initResult == AbstractCommand::initReturn::READY
                    ? cmdStates::INIT_DONE
                    : cmdStates::INIT_ERROR;
     if (hasError()) {
-        cmdOutputBuffer.println("ERROR: init failed");
+        if (textStatus) cmdOutputBuffer.println("ERROR: init failed");
         mustRecycle = true;
     }
 }
@@ -68,15 +84,20 @@ void CommandContext::do_init() {
 void CommandContext::do_run() {
     if (hasError() || mustRecycle) return;
     if (cmdState != cmdStates::INIT_DONE && cmdState != cmdStates::RUN) return;
+    const auto now = clock->micros();
     if (cmdState != cmdStates::RUN) {
-        firstRunMillis = millis();
+        firstRunMicros = now;
+        runDeadline.clear();
+        if (const auto timeout = cmd->getRunTimeoutMicros(); timeout > Deadline::MAX_TIMEOUT) {
+            LIBSMART_STM32SHELL_LOG(ERROR)
+                    ->printf("%s: run timeout out of range, running without timeout\r\n", getName());
+        } else if (timeout > 0) {
+            runDeadline.set(now, timeout);
+        }
     }
     cmdState = cmdStates::RUN;
 
-    //    cmd->runDuration += millis() - cmd->lastRunMillis;
-    lastRunMillis = millis();
-
-    if ((cmd->getRunTimeout() > 0) && (getRunDuration() > cmd->getRunTimeout())) {
+    if (runDeadline.hasExpired(now)) {
         cmdState = cmdStates::RUN_TIMEOUT;
         runResult = AbstractCommand::runReturn::TIMEOUT;
         this->onRunTimeout();
@@ -84,6 +105,7 @@ void CommandContext::do_run() {
 
     if (cmdState == cmdStates::RUN) {
         runResult = cmd->run();
+        runMicros += clock->since(now);
     }
 
     switch (runResult) {
@@ -95,16 +117,24 @@ void CommandContext::do_run() {
             cmdState = cmdStates::RUN;
             break;
 
-        case AbstractCommand::runReturn::UNDEF:
         case AbstractCommand::runReturn::TIMEOUT:
+            cmdState = cmdStates::RUN_TIMEOUT;
+            break;
+
+        case AbstractCommand::runReturn::UNDEF:
         case AbstractCommand::runReturn::ERROR:
             cmdState = cmdStates::RUN_ERROR;
             break;
     }
-    runDuration = getRunDuration();
+    if (cmdState != cmdStates::RUN) {
+        runDuration = clock->since(firstRunMicros);
+        if (metrics != nullptr) metrics->record(CommandMetrics::phase::RUN, runMicros);
+    }
+    // Expired deadline or run() returned TIMEOUT
+    if (cmdState == cmdStates::RUN_TIMEOUT && metrics != nullptr) metrics->countTimeout();
     if (hasError()) this->onRunError();
     if (cmdState != cmdStates::RUN) this->onRunFinished();
-    if (hasError()) cmdOutputBuffer.println("ERROR: run failed");
+    if (hasError() && textStatus) cmdOutputBuffer.println("ERROR: run failed");
 }
 
 void CommandContext::do_cleanup() {
@@ -113,9 +143,9 @@ void CommandContext::do_cleanup() {
         cmdState != cmdStates::RUN_TIMEOUT &&
         cmdState != cmdStates::RUN_ERROR)
         return this->onCmdEnd();
-    cleanupResult = cmd->cleanup();
+    cleanupResult = measure(CommandMetrics::phase::CLEANUP, [this] { return cmd->cleanup(); });
     // cmdOutputBuffer.write("ERROR: cleanup failed\r\n");
-    if (!hasError()) cmdOutputBuffer.println("OK");
+    if (!hasError() && textStatus) cmdOutputBuffer.println("OK");
     mustRecycle = true;
     this->onCleanupFinished();
     this->onCmdEnd();
@@ -123,14 +153,35 @@ void CommandContext::do_cleanup() {
 
 void CommandContext::do_terminate() {
     cmd->terminate();
+    if (metrics != nullptr) metrics->countTermination();
     mustRecycle = true;
     cmdState = cmdStates::TERMINATED;
+    if (!textStatus) return;
     cmdOutputBuffer.print("NOTICE: command `");
     cmdOutputBuffer.print(getCommandLine());
     cmdOutputBuffer.println("` terminated");
     cmdOutputBuffer.println("OK");
 }
 
+CommandContext::result CommandContext::getResult() const {
+    switch (cmdState) {
+        case cmdStates::ARGUMENT_ERROR:
+            return result::ARGUMENT_ERROR;
+        case cmdStates::PREFLIGHTCHECK_ERROR:
+            return result::PREFLIGHTCHECK_ERROR;
+        case cmdStates::INIT_ERROR:
+            return result::INIT_ERROR;
+        case cmdStates::RUN_TIMEOUT:
+            return result::RUN_TIMEOUT;
+        case cmdStates::RUN_ERROR:
+            return result::RUN_ERROR;
+        case cmdStates::TERMINATED:
+            return result::TERMINATED;
+        default:
+            return result::OK;
+    }
+}
+
 void CommandContext::onRunTimeout() {
     cmd->onRunTimeout();
 }
@@ -145,17 +196,18 @@ void CommandContext::onRunFinished() {
 }
 
 void CommandContext::onCleanupFinished() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Command::CommandContext::onCleanupFinished");
     cmd->onCleanupFinished();
     onCleanupFinishedFn();
 }
 
 void CommandContext::onCmdEnd() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Command::CommandContext::onCmdEnd");
     if (cmdOutputBuffer.getLength() > 0) onWriteFn();
     cmd->onCmdEnd();
+    cmdEnded = true;
     onCmdEndFn();
 }
 
@@ -164,7 +216,15 @@ bool CommandContext::isCmdSync() {
 }
 
 void CommandContext::recycle() {
+    if (metrics != nullptr && hasError() && cmdState != cmdStates::TERMINATED) metrics->countError();
+    metrics = nullptr;
+    runMicros = 0;
+    firstRunMicros = 0;
+    runDuration = 0;
+    runDeadline.clear();
+
     cmd->recycle();
+    cmd->setContext(nullptr);
     cmd = nullptr;
     cmdState = cmdStates::UNDEF;
 
@@ -175,12 +235,45 @@ void CommandContext::recycle() {
     cmdOutputBuffer.clear();
 
     mustRecycle = false;
+    cmdEnded = false;
 }
 
 bool CommandContext::isFinished() const {
     return mustRecycle;
 }
 
+bool CommandContext::hasCommand() const {
+    return cmd != nullptr;
+}
+
+bool CommandContext::isRunning() const {
+    return cmd != nullptr && !mustRecycle && cmdState == cmdStates::RUN;
+}
+
+bool CommandContext::isWaiting() {
+    if (!isRunning()) return false;
+    const auto now = clock->micros();
+    if (runDeadline.hasExpired(now)) return false;
+
+    const auto wait = cmd->getWait();
+    if (wait.deadline.hasExpired(now)) return false;
+    if (wait.output > 0) return outputAvailable() < wait.output;
+    return wait.deadline.isArmed();
+}
+
+uint32_t CommandContext::getTimeToDeadline(const uint32_t now) {
+    if (!isRunning()) return UINT32_MAX;
+    uint32_t timeout = runDeadline.isArmed() ? runDeadline.remaining(now) : UINT32_MAX;
+    if (const auto wait = cmd->getWait(); wait.deadline.isArmed()) {
+        timeout = std::min(timeout, wait.deadline.remaining(now));
+    }
+    return timeout;
+}
+
+bool CommandContext::hasEnded() const {
+    return cmdEnded;
+}
+
 const char *CommandContext::getName() {
     return cmd == nullptr ? nullptr : cmd->getName();
 }
@@ -191,7 +284,7 @@ const char *CommandContext::getCommandLine() {
 
 
 bool CommandContext::setCommand(CommandInterface *command) {
-    if (cmd == nullptr) {
+    if (cmd == nullptr && command->getCommandContext() == nullptr) {
         cmd = command;
         cmd->setContext(this);
         return true;
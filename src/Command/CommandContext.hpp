@@ -8,6 +8,9 @@
 
 #include "CommandContextInterface.hpp"
 #include "CommandInterface.hpp"
+#include "CommandMetrics.hpp"
+#include "ClockInterface.hpp"
+#include "CycleCounterClock.hpp"
 #include "Helper.hpp"
 #include "StringBuffer.hpp"
 #include "Loggable.hpp"
@@ -41,8 +44,73 @@ namespace Stm32Shell::Command {
 
         bool hasError();
 
+        /**
+         * @brief Outcome of the attached command.
+         */
+        using u_result = enum class result : uint8_t {
+            OK,                     ///< No error, or not finished yet
+            ARGUMENT_ERROR,         ///< The arguments did not match the argument specs
+            PREFLIGHTCHECK_ERROR,   ///< preFlightCheck() failed
+            INIT_ERROR,             ///< init() failed
+            RUN_ERROR,              ///< run() failed
+            RUN_TIMEOUT,            ///< The run timeout expired
+            TERMINATED              ///< Terminated by do_terminate()
+        };
+
+        /** @return The outcome of the attached command. */
+        result getResult() const;
+
+        /**
+         * @brief Selects whether the outcome is printed as OK/ERROR line into the output.
+         *
+         * A session that reports the outcome in another form, e.g. as status code of a
+         * binary frame, switches the text off.
+         *
+         * @param enable true to print the text lines (default).
+         */
+        void setTextStatus(const bool enable) { textStatus = enable; }
+
         bool isFinished() const;
 
+        /**
+         * @brief Checks whether a command is attached to this context.
+         *
+         * @return true if a command has been set and not yet recycled.
+         */
+        bool hasCommand() const;
+
+        /**
+         * @brief Checks whether the attached command is still in its run phase.
+         *
+         * @return true if the last call to run() returned RUNNING.
+         */
+        bool isRunning() const;
+
+        /**
+         * @brief Checks whether the running command can not make progress yet.
+         *
+         * @return true if the command waits for output space or a deadline, see
+         *         CommandInterface::getWait(), and neither is there yet.
+         */
+        bool isWaiting();
+
+        /**
+         * @brief Returns the time until the running command must be run again.
+         *
+         * The earlier of the run timeout and the deadline the command waits for.
+         *
+         * @param now Current time of the clock [us].
+         * @return Time [us], 0 if due, UINT32_MAX if the command has no deadline.
+         */
+        uint32_t getTimeToDeadline(uint32_t now);
+
+        /**
+         * @brief Checks whether onCmdEnd() has been called for the attached command.
+         *
+         * @return true if the command has ended and only waits to be recycled.
+         */
+        bool hasEnded() const;
+
         bool isCmdSync();
 
         void recycle();
@@ -55,12 +123,40 @@ namespace Stm32Shell::Command {
         void registerOnCleanupFinishedFunction(const fn_t &fn) { this->onCleanupFinishedFn = fn; }
         void registerOnCmdEndFunction(const fn_t &fn) { this->onCmdEndFn = fn; }
         void registerOnWriteFunction(const fn_t &fn) { this->onWriteFn = fn; }
+        void registerOnReserveFunction(const reserveFn_t &fn) { this->onReserveFn = fn; }
+        void registerOnCommitFunction(const commitFn_t &fn) { this->onCommitFn = fn; }
+
 
+        /**
+         * @brief Sets the metrics the attached command is recorded in.
+         *
+         * Must be called after setCommand(), recycle() detaches the metrics.
+         *
+         * @param cmdMetrics Metrics of the command, nullptr to record nothing.
+         */
+        void setMetrics(CommandMetrics *cmdMetrics) { metrics = cmdMetrics; }
 
+        /**
+         * @brief Time [us] since the first call to run(), kept when the run has finished.
+         */
         uint32_t getRunDuration() {
-            return firstRunMillis > 0 ? millis() - firstRunMillis : 0;
+            return cmdState == cmdStates::RUN ? clock->since(firstRunMicros) : runDuration;
         }
 
+        /**
+         * @brief Sets the clock used for timeouts, run durations and metrics of all commands.
+         *
+         * @param newClock The clock, nullptr selects the default CycleCounterClock.
+         */
+        static void setClock(ClockInterface *newClock) { clock = newClock != nullptr ? newClock : &defaultClock; }
+
+        /** @return The clock used by all command contexts. */
+        static ClockInterface *getClock() { return clock; }
+
+#if LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE > 0
+        CoroutineArena *getCoroutineArena() override { return &coroutineArena; }
+#endif
+
     protected:
         void do_preFlightCheck();
 
@@ -111,6 +207,7 @@ namespace Stm32Shell::Command {
         CommandInterface *cmd{};
         using u_cmdStates = enum class cmdStates {
             UNDEF,
+            ARGUMENT_ERROR,
             PREFLIGHTCHECK,
             PREFLIGHTCHECK_DONE,
             PREFLIGHTCHECK_ERROR,
@@ -127,6 +224,11 @@ namespace Stm32Shell::Command {
 
         bool mustRecycle = false;
 
+        /** true: the outcome is printed as OK/ERROR line. */
+        bool textStatus = true;
+
+        bool cmdEnded = false;
+
         /*
         AbstractCommand::preFlightCheckReturn preFlightCheckResult = AbstractCommand::preFlightCheckReturn::UNDEF;
         AbstractCommand::initReturn initResult = AbstractCommand::initReturn::UNDEF;
@@ -135,12 +237,36 @@ namespace Stm32Shell::Command {
         */
         // friend class cmdOutputBufferClass;
 
-        /** The value of millis() when the run was first started. */
-        unsigned long firstRunMillis = 0;
-        /** The value of millis() when the last run started. */
-        unsigned long lastRunMillis = 0;
-        /** Total [ms] since the command started. */
-        unsigned long runDuration = 0;
+        /** Time [us] of the first call to run(). */
+        uint32_t firstRunMicros = 0;
+        /** Time [us] from the first call to run() until the run finished. */
+        uint32_t runDuration = 0;
+        /** Expires when the run timeout of the command is reached. */
+        Deadline runDeadline;
+
+        inline static CycleCounterClock defaultClock;
+        inline static ClockInterface *clock = &defaultClock;
+
+        /** Metrics of the attached command, nullptr if not recorded. */
+        CommandMetrics *metrics = nullptr;
+        /** Time [us] spent in run() during this invocation. */
+        uint32_t runMicros = 0;
+
+#if LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE > 0
+        /** Frames of the coroutine commands run in this context. */
+        StaticCoroutineArena<LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE> coroutineArena;
+#endif
+
+        /**
+         * @brief Calls fn and records its duration for the given phase.
+         */
+        template<typename Fn>
+        auto measure(const CommandMetrics::phase p, Fn fn) {
+            const auto start = clock->micros();
+            const auto ret = fn();
+            if (metrics != nullptr) metrics->record(p, clock->since(start));
+            return ret;
+        }
 
 
     };
@@ -6,6 +6,7 @@
 #ifndef LIBSMART_STM32SHELL_COMMAND_COMMANDCONTEXTINTERFACE_HPP
 #define LIBSMART_STM32SHELL_COMMAND_COMMANDCONTEXTINTERFACE_HPP
 
+#include "CoroutineArena.hpp"
 #include "StringBuffer.hpp"
 
 #define LIBSMART_STM32SHELL_COMMAND_OUTPUT_BUFFER_SIZE 256
@@ -22,9 +23,62 @@ namespace Stm32Shell::Command {
     public:
         using fn_t = std::function<void()>;
 
+        /**
+         * @brief Contiguous writable span in the output transport.
+         */
+        struct outputSpan_t {
+            char *ptr = nullptr;    ///< Start of the writable memory
+            size_t size = 0;        ///< Number of bytes that may be written
+        };
+
+        using reserveFn_t = std::function<outputSpan_t()>;
+        using commitFn_t = std::function<void(size_t)>;
+
         virtual ~CommandContextInterface() = default;
 
+        /**
+         * @brief Returns the arena for the coroutine frames of the attached command.
+         *
+         * @return The arena of the session, nullptr if coroutines are not configured.
+         */
+        virtual CoroutineArena *getCoroutineArena() { return nullptr; }
+
     protected:
+        /**
+         * @brief Reserves a span directly in the output transport.
+         *
+         * Pending bytes in cmdOutputBuffer are flushed first. If they do not fit,
+         * an empty span is returned, so the output order is preserved.
+         *
+         * @return The writable span, size is 0 if the transport is full.
+         */
+        outputSpan_t reserveOutput() {
+            if (cmdOutputBuffer.getLength() > 0) onWriteFn();
+            if (cmdOutputBuffer.getLength() > 0) return {};
+            return onReserveFn();
+        }
+
+        /**
+         * @brief Returns the number of bytes that can be written without losing output.
+         *
+         * Commands producing long reports should check this before writing and
+         * return RUNNING to yield until the transport has drained.
+         *
+         * @return Free space in the transport plus free space in cmdOutputBuffer.
+         */
+        size_t outputAvailable() {
+            return reserveOutput().size + cmdOutputBuffer.getRemainingSpace();
+        }
+
+        /**
+         * @brief Commits bytes written into a span returned by reserveOutput().
+         *
+         * @param len Number of bytes written, must not exceed the reserved size.
+         */
+        void commitOutput(size_t len) {
+            if (len > 0) onCommitFn(len);
+        }
+
         class cmdOutputBufferClass final : public Stm32Common::StringBuffer<
                     LIBSMART_STM32SHELL_COMMAND_OUTPUT_BUFFER_SIZE> {
         public:
@@ -51,6 +105,11 @@ namespace Stm32Shell::Command {
         };
         fn_t onWriteFn = []() {
         };
+        reserveFn_t onReserveFn = []() {
+            return outputSpan_t{};
+        };
+        commitFn_t onCommitFn = [](size_t) {
+        };
     };
 }
 #endif
@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include "Nameable.hpp"
+#include "ClockInterface.hpp"
 #include "CommandContextInterface.hpp"
 
 namespace Stm32Shell::Command {
@@ -117,10 +118,100 @@ namespace Stm32Shell::Command {
 
         virtual bool isCmdSync() = 0;
 
+        /**
+         * @return Time [ms] the run phase may take, 0 for no timeout.
+         */
         virtual uint32_t getRunTimeout() = 0;
 
+        /**
+         * @brief Returns the run timeout with microsecond resolution.
+         *
+         * The shell uses this method. The default converts getRunTimeout(), so a
+         * command that only overrides the millisecond variant keeps its timeout.
+         *
+         * @return Time [us] the run phase may take, 0 for no timeout. UINT32_MAX if
+         *         the timeout does not fit.
+         */
+        virtual uint32_t getRunTimeoutMicros() {
+            const uint64_t us = static_cast<uint64_t>(getRunTimeout()) * 1000;
+            return us < UINT32_MAX ? static_cast<uint32_t>(us) : UINT32_MAX;
+        }
+
+        /**
+         * @brief Condition a running command waits for before run() can make progress.
+         */
+        struct wait_t {
+            size_t output = 0;  ///< Output space [bytes] needed, 0 if not waiting for output
+            Deadline deadline;  ///< Time of the next step, not armed if not waiting for time
+        };
+
+        /**
+         * @brief Returns what the command waits for after run() returned RUNNING.
+         *
+         * The session is not serviced again until the transport has made room for
+         * the output, or the deadline has expired, whichever comes first. A command
+         * waiting for nothing is run again at once.
+         *
+         * @return The wait condition. The default waits for nothing.
+         */
+        virtual wait_t getWait() { return {}; }
+
         virtual void setParam(int argc, const char *const *argv) = 0;
 
+        /**
+         * @brief Returns why the arguments given to setParam() are invalid.
+         *
+         * Checked before preFlightCheck(), the command is not executed if there is an error.
+         *
+         * @return Error message, or nullptr if the arguments are valid. The default accepts all arguments.
+         */
+        virtual const char *getArgumentError() { return nullptr; }
+
+        /**
+         * @brief Creates a new instance of this command for a single session.
+         *
+         * The registered command acts as prototype. Every session executes its own
+         * instance, so the argument and state members are not shared between sessions.
+         *
+         * @return A new instance, or nullptr if the registered instance is shared.
+         *         A shared instance can only be used by one session at a time.
+         */
+        virtual CommandInterface *factory() = 0;
+
+        /**
+         * @brief Gives an instance created by factory() back.
+         *
+         * Called by the shell after the instance has been recycled. The instance
+         * must not be used afterwards.
+         */
+        virtual void release() = 0;
+
+        /**
+         * @brief Returns the command context this command is currently bound to.
+         *
+         * @return The context, or nullptr if the command is not in use.
+         */
+        virtual CommandContextInterface *getCommandContext() = 0;
+
+        /**
+         * @brief Sorted list of words, used for tab completion of arguments.
+         */
+        struct vocabulary_t {
+            const char *const *words = nullptr;     ///< Words, sorted ascending by strcmp()
+            size_t count = 0;                       ///< Number of words
+        };
+
+        /**
+         * @brief Returns the words that can be completed at the given argument position.
+         *
+         * @param argIndex Position of the argument, 1 is the first argument after the command name.
+         * @return The vocabulary for this position. The default has no words.
+         */
+        virtual vocabulary_t getVocabulary(int argIndex) {
+            (void) argIndex;
+            return {};
+        }
+
     protected:
         virtual void onRunTimeout() = 0;
 
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CommandMetrics.hpp"
+
+using namespace Stm32Shell::Command;
+
+uint32_t CommandMetrics::histogram_t::count() const {
+    uint32_t ret = 0;
+    for (const auto bucket: buckets) ret += bucket;
+    return ret;
+}
+
+uint32_t CommandMetrics::histogram_t::mean() const {
+    const auto n = count();
+    return n == 0 ? 0 : static_cast<uint32_t>(sum / n);
+}
+
+void CommandMetrics::record(const phase p, const uint32_t us) {
+    auto &histogram = phases[static_cast<uint8_t>(p)];
+    if (us < histogram.min) histogram.min = us;
+    if (us > histogram.max) histogram.max = us;
+    histogram.sum += us;
+    histogram.buckets[bucketOf(us)]++;
+}
+
+void CommandMetrics::reset() {
+    *this = CommandMetrics{};
+}
+
+const char *CommandMetrics::phaseName(const phase p) {
+    switch (p) {
+        case phase::PREFLIGHTCHECK:
+            return "preflightcheck";
+        case phase::INIT:
+            return "init";
+        case phase::RUN:
+            return "run";
+        case phase::CLEANUP:
+            return "cleanup";
+    }
+    return "";
+}
+
+size_t CommandMetrics::bucketOf(const uint32_t us) {
+    if (us < 4) return 0;
+    // floor(log4(us))
+    const size_t bucket = (31 - __builtin_clz(us)) / 2;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
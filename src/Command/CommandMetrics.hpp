@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_COMMANDMETRICS_HPP
+#define LIBSMART_STM32SHELL_COMMAND_COMMANDMETRICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/** Number of histogram buckets per phase, bucket i counts durations below 4^(i+1) us */
+#ifndef LIBSMART_STM32SHELL_METRICS_BUCKETS
+#define LIBSMART_STM32SHELL_METRICS_BUCKETS 12
+#endif
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Counters and timing histograms of one command.
+     *
+     * The durations of preFlightCheck(), init(), run() and cleanup() are
+     * recorded in microseconds. For an asynchronous command, the run time is
+     * the sum of all calls to run() of one invocation.
+     *
+     * The histograms have logarithmic buckets. Bucket 0 counts durations
+     * below 4 us, bucket i counts durations in [4^i, 4^(i+1)) us, the last
+     * bucket also counts all longer durations.
+     */
+    class CommandMetrics {
+    public:
+        using u_phase = enum class phase : uint8_t {
+            PREFLIGHTCHECK, INIT, RUN, CLEANUP
+        };
+
+        /** Number of phases. */
+        static constexpr size_t PHASE_COUNT = 4;
+
+        /** Number of histogram buckets per phase. */
+        static constexpr size_t BUCKET_COUNT = LIBSMART_STM32SHELL_METRICS_BUCKETS;
+
+        static_assert(BUCKET_COUNT > 0 && BUCKET_COUNT <= 15, "Bucket limits must fit into 32 bit");
+
+        /**
+         * @brief Duration statistics of one phase.
+         */
+        struct histogram_t {
+            uint32_t min = UINT32_MAX;              ///< Shortest duration [us]
+            uint32_t max = 0;                       ///< Longest duration [us]
+            uint64_t sum = 0;                       ///< Sum of all durations [us]
+            uint32_t buckets[BUCKET_COUNT] = {};    ///< Number of durations per bucket
+
+            /** @return Number of recorded durations. */
+            uint32_t count() const;
+
+            /** @return Mean duration [us], 0 if nothing has been recorded. */
+            uint32_t mean() const;
+        };
+
+        /** @brief Counts a started command. */
+        void countInvocation() { invocations++; }
+
+        /** @brief Counts a command that failed, including timeouts. */
+        void countError() { errors++; }
+
+        /** @brief Counts a command whose run timeout expired. */
+        void countTimeout() { timeouts++; }
+
+        /** @brief Counts a command terminated by the user. */
+        void countTermination() { terminations++; }
+
+        /**
+         * @brief Records the duration of a phase.
+         *
+         * @param p  The phase.
+         * @param us Duration in microseconds.
+         */
+        void record(phase p, uint32_t us);
+
+        /** @brief Clears all counters and histograms. */
+        void reset();
+
+        uint32_t getInvocations() const { return invocations; }
+        uint32_t getErrors() const { return errors; }
+        uint32_t getTimeouts() const { return timeouts; }
+        uint32_t getTerminations() const { return terminations; }
+
+        const histogram_t &getHistogram(phase p) const { return phases[static_cast<uint8_t>(p)]; }
+
+        /** @return Name of the phase, as used in the stats output. */
+        static const char *phaseName(phase p);
+
+        /** @return Index of the bucket counting a duration. */
+        static size_t bucketOf(uint32_t us);
+
+        /** @return Exclusive upper limit [us] of a bucket, 4^(bucket+1). */
+        static uint32_t bucketLimit(size_t bucket) {
+            return 4U << (2 * bucket);
+        }
+
+    private:
+        uint32_t invocations = 0;
+        uint32_t errors = 0;
+        uint32_t timeouts = 0;
+        uint32_t terminations = 0;
+        histogram_t phases[PHASE_COUNT] = {};
+    };
+}
+
+#endif
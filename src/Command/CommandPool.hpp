@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_COMMANDPOOL_HPP
+#define LIBSMART_STM32SHELL_COMMAND_COMMANDPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "Nameable.hpp"
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_POOL_SIZE
+#define LIBSMART_STM32SHELL_COMMAND_POOL_SIZE 2
+#endif
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Type independent view on a command pool, used for statistics.
+     *
+     * Every pool links itself into a global list on construction, so all pools
+     * can be listed with first() / getNext().
+     */
+    class CommandPoolInterface : public Stm32Common::Nameable {
+    public:
+        CommandPoolInterface() : next(firstPool) {
+            firstPool = this;
+        }
+
+        CommandPoolInterface(const CommandPoolInterface &) = delete;
+
+        CommandPoolInterface &operator=(const CommandPoolInterface &) = delete;
+
+        /** @return Number of objects the pool can hold. */
+        virtual size_t getCapacity() const = 0;
+
+        /** @return Number of objects currently allocated. */
+        size_t getUsed() const { return used; }
+
+        /** @return Maximum number of objects allocated at the same time. */
+        size_t getHighWater() const { return highWater; }
+
+        /** @return Number of allocations that failed because the pool was empty. */
+        size_t getFailures() const { return failures; }
+
+        /** @return The next pool in the global list, nullptr at the end. */
+        CommandPoolInterface *getNext() const { return next; }
+
+        /** @return The first pool in the global list. */
+        static CommandPoolInterface *first() { return firstPool; }
+
+    protected:
+        size_t used = 0;
+        size_t highWater = 0;
+        size_t failures = 0;
+
+    private:
+        CommandPoolInterface *next;
+        inline static CommandPoolInterface *firstPool = nullptr;
+    };
+
+
+    /**
+     * @brief Fixed capacity pool for command objects of type T.
+     *
+     * The memory for all N objects is part of the pool, so no heap is used.
+     * allocate() and free() are O(1) operations on a free list of slot indices.
+     *
+     * @tparam T Object type.
+     * @tparam N Number of objects.
+     */
+    template<class T, size_t N>
+    class CommandPool final : public CommandPoolInterface {
+        static_assert(N > 0 && N < UINT8_MAX, "Pool size must be in 1..254");
+
+    public:
+        CommandPool() {
+            for (size_t i = 0; i < N; i++) {
+                nextFree[i] = static_cast<uint8_t>(i + 1);
+            }
+        }
+
+        /**
+         * @brief Constructs a new T in a free slot.
+         *
+         * @return The new object, or nullptr if the pool is exhausted.
+         */
+        T *allocate() {
+            if (freeHead >= N) {
+                failures++;
+                return nullptr;
+            }
+            const auto slot = freeHead;
+            freeHead = nextFree[slot];
+            used++;
+            if (used > highWater) highWater = used;
+            return new(storage[slot]) T();
+        }
+
+        /**
+         * @brief Destroys an object and returns its slot to the pool.
+         *
+         * @param obj An object returned by allocate(). nullptr is ignored.
+         */
+        void free(T *obj) {
+            if (obj == nullptr) return;
+            const auto offset = reinterpret_cast<uintptr_t>(obj) - reinterpret_cast<uintptr_t>(storage);
+            const auto slot = offset / sizeof(T);
+            if (slot >= N || offset % sizeof(T) != 0) return;
+            obj->~T();
+            nextFree[slot] = freeHead;
+            freeHead = static_cast<uint8_t>(slot);
+            used--;
+        }
+
+        size_t getCapacity() const override { return N; }
+
+    private:
+        alignas(T) unsigned char storage[N][sizeof(T)]{};
+        uint8_t nextFree[N]{};
+        uint8_t freeHead = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CoroutineArena.hpp"
+
+using namespace Stm32Shell::Command;
+
+void *CoroutineArena::allocate(const size_t len) {
+    constexpr size_t align = alignof(std::max_align_t);
+    const size_t need = sizeof(header_t) + (len + align - 1) / align * align;
+    if (need > size - top) {
+        failures++;
+        return nullptr;
+    }
+
+    auto *header = headerAt(top);
+    header->arena = this;
+    header->prev = last;
+    header->freed = false;
+    last = top;
+    top += need;
+    if (top > highWater) highWater = top;
+    return header + 1;
+}
+
+void CoroutineArena::deallocate(void *ptr) {
+    if (ptr == nullptr) return;
+    auto *header = static_cast<header_t *>(ptr) - 1;
+    header->freed = true;
+
+    // Reclaim all freed frames at the top
+    auto *arena = header->arena;
+    while (arena->last != NONE && arena->headerAt(arena->last)->freed) {
+        arena->top = arena->last;
+        arena->last = arena->headerAt(arena->last)->prev;
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_COROUTINEARENA_HPP
+#define LIBSMART_STM32SHELL_COMMAND_COROUTINEARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bytes per session for the frames of CoroutineCommand, 0 disables them. Opt-in, e.g. 512
+ * in libsmart_config.hpp. The size is part of the layout of CommandContext, so it must not
+ * depend on the language standard of a translation unit.
+ */
+#ifndef LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE
+#define LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE 0
+#endif
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Stack allocator for coroutine frames.
+     *
+     * A coroutine awaits its nested coroutines, so frames are freed in reverse
+     * order of allocation. A frame freed out of order is only marked, its space
+     * is reclaimed together with the frames above it.
+     *
+     * Each frame remembers its arena, so it can be freed from any context.
+     */
+    class CoroutineArena {
+    public:
+        CoroutineArena(uint8_t *buf, const size_t size) : buf(buf), size(size) {
+        }
+
+        CoroutineArena(const CoroutineArena &) = delete;
+
+        CoroutineArena &operator=(const CoroutineArena &) = delete;
+
+        /**
+         * @brief Allocates a frame.
+         *
+         * @param len Size of the frame.
+         * @return The frame, or nullptr if the arena is full.
+         */
+        void *allocate(size_t len);
+
+        /**
+         * @brief Frees a frame returned by allocate() of any arena.
+         *
+         * @param ptr The frame. nullptr is ignored.
+         */
+        static void deallocate(void *ptr);
+
+        /** @return Size of the arena. */
+        size_t getCapacity() const { return size; }
+
+        /** @return Bytes in use, including frame headers. */
+        size_t getUsed() const { return top; }
+
+        /** @return Maximum number of bytes in use at the same time. */
+        size_t getHighWater() const { return highWater; }
+
+        /** @return Number of allocations that failed because the arena was full. */
+        size_t getFailures() const { return failures; }
+
+        /** @return The arena new frames are allocated from, nullptr if none. */
+        static CoroutineArena *getCurrent() { return current; }
+
+        /**
+         * @brief Selects the arena for new frames while in scope.
+         */
+        class scope {
+        public:
+            explicit scope(CoroutineArena *arena) : prev(current) { current = arena; }
+
+            ~scope() { current = prev; }
+
+            scope(const scope &) = delete;
+
+            scope &operator=(const scope &) = delete;
+
+        private:
+            CoroutineArena *prev;
+        };
+
+    private:
+        struct alignas(alignof(std::max_align_t)) header_t {
+            CoroutineArena *arena;  ///< Arena the frame belongs to
+            size_t prev;            ///< Offset of the frame below, NONE for the first one
+            bool freed;             ///< Freed, but not at the top of the arena yet
+        };
+
+        /** Marks the absence of a frame. */
+        static constexpr size_t NONE = SIZE_MAX;
+
+        uint8_t *buf;
+        size_t size;
+        /** Offset of the first free byte. */
+        size_t top = 0;
+        /** Offset of the header of the topmost frame. */
+        size_t last = NONE;
+        size_t highWater = 0;
+        size_t failures = 0;
+
+        inline static CoroutineArena *current = nullptr;
+
+        header_t *headerAt(const size_t offset) {
+            return reinterpret_cast<header_t *>(buf + offset);
+        }
+    };
+
+
+    /**
+     * @brief Coroutine arena with its own memory.
+     *
+     * @tparam N Size in bytes.
+     */
+    template<size_t N>
+    class StaticCoroutineArena final : public CoroutineArena {
+    public:
+        StaticCoroutineArena() : CoroutineArena(memory, N) {
+        }
+
+    private:
+        alignas(alignof(std::max_align_t)) uint8_t memory[N]{};
+    };
+}
+
+#endif
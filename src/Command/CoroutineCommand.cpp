@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#if defined(__cpp_impl_coroutine)
+
+#include "CoroutineCommand.hpp"
+
+using namespace Stm32Shell::Command;
+
+CommandInterface::initReturn CoroutineCommand::init() {
+    const auto ret = AbstractCommand::init();
+    if (ret != initReturn::READY) return ret;
+
+    arena = getCommandContext() != nullptr ? getCommandContext()->getCoroutineArena() : nullptr;
+    if (arena == nullptr) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->printf("%s: no coroutine arena, LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE is 0\r\n", getName());
+        return initReturn::ERROR;
+    }
+
+    {
+        CoroutineArena::scope s(arena);
+        task = body();
+    }
+    if (!task.isValid()) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->printf("%s: coroutine arena full (%lu of %lu bytes used)\r\n", getName(),
+                         static_cast<unsigned long>(arena->getUsed()),
+                         static_cast<unsigned long>(arena->getCapacity()));
+        return initReturn::ERROR;
+    }
+
+    // The coroutine starts suspended, the first run() enters it
+    resumeHandle = task.handle;
+    clearWait();
+    waitYield = true;
+    return initReturn::READY;
+}
+
+CommandInterface::runReturn CoroutineCommand::run() {
+    if (!task.isValid()) return runReturn::ERROR;
+    if (!isWaitOver()) return runReturn::RUNNING;
+
+    {
+        CoroutineArena::scope s(arena);
+        resumeHandle.resume();
+    }
+    if (!task.isDone()) return runReturn::RUNNING;
+
+    const auto result = task.getResult();
+    task = {};
+    return result;
+}
+
+bool CoroutineCommand::isWaitOver() {
+    if (waitYield) return true;
+    if (waitDeadline.hasExpired(CommandContext::getClock()->micros())) return true;
+    return waitOutputSize > 0 && outputAvailable() >= waitOutputSize;
+}
+
+#endif
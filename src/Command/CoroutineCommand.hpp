@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_COROUTINECOMMAND_HPP
+#define LIBSMART_STM32SHELL_COMMAND_COROUTINECOMMAND_HPP
+
+#if !defined(__cpp_impl_coroutine)
+#error "CoroutineCommand requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <utility>
+#include "AbstractCommand.hpp"
+#include "CoroutineArena.hpp"
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Coroutine returning the result of a command run.
+     *
+     * The frame is allocated from the current CoroutineArena, never from the
+     * heap. The coroutine starts suspended. Awaiting a task runs it to
+     * completion and yields its result, runReturn::ERROR if the arena was full.
+     */
+    class CommandTask {
+    public:
+        struct promise_type {
+            CommandInterface::runReturn result = CommandInterface::runReturn::FINISHED;
+            /** Coroutine awaiting this one, resumed when it has finished. */
+            std::coroutine_handle<> continuation;
+
+            static void *operator new(const size_t size) noexcept {
+                auto *arena = CoroutineArena::getCurrent();
+                return arena != nullptr ? arena->allocate(size) : nullptr;
+            }
+
+            static void operator delete(void *ptr) noexcept {
+                CoroutineArena::deallocate(ptr);
+            }
+
+            static CommandTask get_return_object_on_allocation_failure() noexcept { return {}; }
+
+            CommandTask get_return_object() noexcept {
+                return CommandTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct finalAwaiter {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    const auto next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {
+                }
+            };
+
+            finalAwaiter final_suspend() noexcept { return {}; }
+
+            void return_value(const CommandInterface::runReturn r) noexcept { result = r; }
+
+            void unhandled_exception() noexcept { result = CommandInterface::runReturn::ERROR; }
+        };
+
+        CommandTask() = default;
+
+        explicit CommandTask(const std::coroutine_handle<promise_type> h) : handle(h) {
+        }
+
+        CommandTask(CommandTask &&other) noexcept : handle(std::exchange(other.handle, {})) {
+        }
+
+        CommandTask &operator=(CommandTask &&other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        CommandTask(const CommandTask &) = delete;
+
+        CommandTask &operator=(const CommandTask &) = delete;
+
+        ~CommandTask() {
+            if (handle) handle.destroy();
+        }
+
+        /** @return false if the frame could not be allocated. */
+        bool isValid() const { return static_cast<bool>(handle); }
+
+        /** @return true if the coroutine has returned. */
+        bool isDone() const { return handle && handle.done(); }
+
+        /** @return The value of co_return, ERROR if the frame could not be allocated. */
+        CommandInterface::runReturn getResult() const {
+            return handle ? handle.promise().result : CommandInterface::runReturn::ERROR;
+        }
+
+        bool await_ready() const noexcept { return !handle; }
+
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<> parent) noexcept {
+            handle.promise().continuation = parent;
+            return handle;
+        }
+
+        CommandInterface::runReturn await_resume() const noexcept { return getResult(); }
+
+    private:
+        friend class CoroutineCommand;
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+
+    /**
+     * @brief Base class for asynchronous commands written as a coroutine.
+     *
+     * Instead of a state machine around runReturn::RUNNING, the command
+     * implements body() and suspends with co_await where it would block:
+     *
+     *   CommandTask body() override {
+     *       for (int i = 0; i < 100; i++) {
+     *           co_await waitOutput(32);
+     *           printf("%d\r\n", i);
+     *           co_await delay(10);
+     *       }
+     *       co_return runReturn::FINISHED;
+     *   }
+     *
+     * Every call to run() by the CommandContext resumes the coroutine when the
+     * awaited condition is met, so the shell stays responsive. Run timeout and
+     * Ctrl+C work as for every other command, the frames are destroyed then.
+     * Other coroutines returning CommandTask can be awaited as sub routines.
+     *
+     * The frames come from the CoroutineArena of the session, sized by
+     * LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE. The arena is opt-in, init()
+     * fails while the size is 0 or the arena is full.
+     */
+    class CoroutineCommand : public AbstractCommand {
+    public:
+        CoroutineCommand() {
+            isSync = false;
+        }
+
+        /**
+         * @brief Creates the coroutine. Derived classes overriding init() must call it.
+         */
+        initReturn init() override;
+
+        runReturn run() final;
+
+        void terminate() override {
+            task = {};
+            AbstractCommand::terminate();
+        }
+
+        void recycle() override {
+            task = {};
+            AbstractCommand::recycle();
+        }
+
+        /** @return The output space and time the coroutine is suspended for, nothing after yield(). */
+        wait_t getWait() override {
+            if (waitYield) return {};
+            return {waitOutputSize, waitDeadline};
+        }
+
+    protected:
+        /**
+         * @brief The command as a coroutine, co_return the result of the run.
+         */
+        virtual CommandTask body() = 0;
+
+        /**
+         * @brief Awaitable for a condition checked by run().
+         *
+         * co_await yields true if the awaited output space is available,
+         * false if the timeout expired first.
+         */
+        class waitAwaiter {
+        public:
+            explicit waitAwaiter(CoroutineCommand &cmd) : cmd(cmd) {
+            }
+
+            bool await_ready() { return cmd.isWaitOver(); }
+
+            void await_suspend(const std::coroutine_handle<> h) { cmd.resumeHandle = h; }
+
+            bool await_resume() {
+                const bool ok = cmd.waitOutputSize == 0 || cmd.outputAvailable() >= cmd.waitOutputSize;
+                cmd.clearWait();
+                return ok;
+            }
+
+        private:
+            CoroutineCommand &cmd;
+        };
+
+        /** @brief Suspends until the next call to run(). */
+        waitAwaiter yield() {
+            clearWait();
+            waitYield = true;
+            return waitAwaiter{*this};
+        }
+
+        /**
+         * @brief Suspends until len bytes can be written without losing output.
+         *
+         * @param len       Number of bytes, at most the size of the output buffers.
+         * @param timeoutMs Maximum time to wait [ms], 0 to wait without limit.
+         */
+        waitAwaiter waitOutput(const size_t len, const uint32_t timeoutMs = 0) {
+            clearWait();
+            waitOutputSize = len > 0 ? len : 1;
+            if (timeoutMs > 0) waitDeadline.set(CommandContext::getClock()->micros(), timeoutMs * 1000U);
+            return waitAwaiter{*this};
+        }
+
+        /** @brief Suspends for a time [ms]. */
+        waitAwaiter delay(const uint32_t ms) {
+            return delayMicros(ms * 1000U);
+        }
+
+        /** @brief Suspends for a time [us], at most 2^31 - 1. */
+        waitAwaiter delayMicros(const uint32_t us) {
+            clearWait();
+            waitDeadline.set(CommandContext::getClock()->micros(), us);
+            return waitAwaiter{*this};
+        }
+
+    private:
+        /** The body() of the current invocation. */
+        CommandTask task;
+        /** Innermost suspended coroutine, resumed by run(). */
+        std::coroutine_handle<> resumeHandle;
+        /** Arena of the session the command runs in. */
+        CoroutineArena *arena = nullptr;
+
+        /** true: resume on the next run(). */
+        bool waitYield = false;
+        /** Output space [bytes] to wait for, 0 for none. */
+        size_t waitOutputSize = 0;
+        /** Expires when a delay or a wait timeout is over. */
+        Deadline waitDeadline;
+
+        bool isWaitOver();
+
+        void clearWait() {
+            waitYield = false;
+            waitOutputSize = 0;
+            waitDeadline.clear();
+        }
+    };
+}
+
+#endif
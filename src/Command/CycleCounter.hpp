@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_CYCLECOUNTER_HPP
+#define LIBSMART_STM32SHELL_COMMAND_CYCLECOUNTER_HPP
+
+#include <cstdint>
+#include "main.hpp"
+
+#if !defined(DWT) && (defined(__linux__) || defined(__APPLE__) || defined(_WIN32))
+#include <chrono>
+#endif
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Free running counter for measuring short durations.
+     *
+     * Counts CPU cycles with the DWT cycle counter on Cortex-M targets, and
+     * nanoseconds of std::chrono::steady_clock on a host. Targets without DWT
+     * fall back to millis(). The difference of two readings is wrap safe, as
+     * long as the measured duration is shorter than one counter period
+     * (about 8.9 s at 480 MHz).
+     */
+    class CycleCounter {
+    public:
+        /**
+         * @brief Starts the counter. Can be called more than once.
+         */
+        static void begin() {
+#if defined(DWT)
+#if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+            DWT->LAR = 0xC5ACCE55;
+#endif
+            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+        }
+
+        /** @return The current counter value in ticks. */
+        static uint32_t now() {
+#if defined(DWT)
+            return DWT->CYCCNT;
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+            return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+            return static_cast<uint32_t>(millis());
+#endif
+        }
+
+        /** @return The ticks between start and now(). */
+        static uint32_t since(const uint32_t start) {
+            return now() - start;
+        }
+
+        /** @return Duration of ticks in microseconds. */
+        static uint32_t toMicros(const uint32_t ticks) {
+#if defined(DWT)
+            const uint32_t perMicro = SystemCoreClock / 1000000U;
+            return perMicro == 0 ? ticks : ticks / perMicro;
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+            return ticks / 1000U;
+#else
+            return ticks * 1000U;
+#endif
+        }
+
+        /** @return Ticks of a duration in microseconds, the inverse of toMicros(). */
+        static uint32_t fromMicros(const uint32_t us) {
+#if defined(DWT)
+            const uint32_t perMicro = SystemCoreClock / 1000000U;
+            return perMicro == 0 ? us : us * perMicro;
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+            return us * 1000U;
+#else
+            return us / 1000U;
+#endif
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_CYCLECOUNTERCLOCK_HPP
+#define LIBSMART_STM32SHELL_COMMAND_CYCLECOUNTERCLOCK_HPP
+
+#include "ClockInterface.hpp"
+#include "CycleCounter.hpp"
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Clock counting microseconds with the CycleCounter.
+     *
+     * The cycle counter wraps much faster than the clock (about 8.9 s at
+     * 480 MHz), so micros() must be called at least once per cycle counter
+     * period to keep up with the time. The shell does so from every loop().
+     * Ticks that do not make up a full microsecond are carried over, so the
+     * clock does not drift.
+     */
+    class CycleCounterClock : public ClockInterface {
+    public:
+        CycleCounterClock() {
+            CycleCounter::begin();
+            lastTicks = CycleCounter::now();
+        }
+
+        uint32_t micros() override {
+            const auto us = CycleCounter::toMicros(CycleCounter::since(lastTicks));
+            lastTicks += CycleCounter::fromMicros(us);
+            time += us;
+            return time;
+        }
+
+    private:
+        uint32_t lastTicks = 0;
+        uint32_t time = 0;
+    };
+}
+
+#endif
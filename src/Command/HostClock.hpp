@@ -0,0 +1,40 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_HOSTCLOCK_HPP
+#define LIBSMART_STM32SHELL_COMMAND_HOSTCLOCK_HPP
+
+#include <chrono>
+#include "ClockInterface.hpp"
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Clock based on std::chrono::steady_clock, for running on a host.
+     *
+     * The offset is added to the time, so a test can start just before the
+     * wrap around of the 32 bit microseconds.
+     */
+    class HostClock : public ClockInterface {
+    public:
+        explicit HostClock(const uint32_t offset = 0) : offset(offset) { ; }
+
+        uint32_t micros() override {
+            return offset + static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                      std::chrono::steady_clock::now() - start).count());
+        }
+
+        /** @brief Sets the offset, micros() continues from there. */
+        void setOffset(const uint32_t newOffset) {
+            offset = newOffset;
+            start = std::chrono::steady_clock::now();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint32_t offset;
+    };
+}
+
+#endif
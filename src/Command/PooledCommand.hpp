@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_COMMAND_POOLEDCOMMAND_HPP
+#define LIBSMART_STM32SHELL_COMMAND_POOLEDCOMMAND_HPP
+
+#include "AbstractCommand.hpp"
+#include "CommandPool.hpp"
+
+namespace Stm32Shell::Command {
+    /**
+     * @brief Pool holding the session instances of command type T.
+     *
+     * A variable template instead of a static member, so it is instantiated only
+     * where T is a complete type.
+     */
+    template<class T, size_t N>
+    inline CommandPool<T, N> commandPool{};
+
+    /**
+     * @brief Base class for commands whose session instances come from a fixed pool.
+     *
+     * Usage: class MyCommand : public PooledCommand<MyCommand> { ... };
+     * The registered instance is the prototype. factory() constructs a session
+     * instance in the pool, release() returns it. No heap is used.
+     *
+     * @tparam T The derived command type.
+     * @tparam N Number of instances, i.e. sessions that may run the command at the same time.
+     */
+    template<class T, size_t N = LIBSMART_STM32SHELL_COMMAND_POOL_SIZE>
+    class PooledCommand : public AbstractCommand {
+    public:
+        AbstractCommand *factory() override {
+            auto &pool = commandPool<T, N>;
+            if (pool.getName() == nullptr || *pool.getName() == '\0') pool.setName(getName());
+            return pool.allocate();
+        }
+
+        void release() override {
+            commandPool<T, N>.free(static_cast<T *>(this));
+        }
+
+        /** @return The pool of this command type. */
+        static CommandPoolInterface *getPool() { return &commandPool<T, N>; }
+    };
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_LOG_HPP
+#define LIBSMART_STM32SHELL_LOG_HPP
+
+#include <libsmart_config.hpp>
+#include "Loggable.hpp"
+
+/*
+ * Numeric log levels, ordered like Stm32ItmLogger::LoggerInterface::Severity.
+ * A message is logged, if its level is less than or equal to the configured level.
+ */
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_EMERGENCY 0
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_ALERT 1
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_CRITICAL 2
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_ERROR 3
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_WARNING 4
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_NOTICE 5
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_INFORMATIONAL 6
+#define LIBSMART_STM32SHELL_LOG_SEVERITY_DEBUGGING 7
+
+/** Compile time log level, messages above this level are removed from the binary. */
+#ifndef LIBSMART_STM32SHELL_LOG_LEVEL
+#define LIBSMART_STM32SHELL_LOG_LEVEL LIBSMART_STM32SHELL_LOG_SEVERITY_WARNING
+#endif
+
+/** true, if messages of the given severity are compiled in. */
+#define LIBSMART_STM32SHELL_LOG_ENABLED(severity) \
+    (LIBSMART_STM32SHELL_LOG_SEVERITY_##severity <= LIBSMART_STM32SHELL_LOG_LEVEL)
+
+/**
+ * @brief Logs through the Loggable::log() of the current object.
+ *
+ * Usage: LIBSMART_STM32SHELL_LOG(INFORMATIONAL)->println("...");
+ * Below the compile time level the whole statement, including the evaluation of
+ * its arguments, is discarded. Above it, the runtime level is checked before the
+ * logger is called.
+ */
+#define LIBSMART_STM32SHELL_LOG(severity) \
+    if constexpr (!LIBSMART_STM32SHELL_LOG_ENABLED(severity)) {} \
+    else if (LIBSMART_STM32SHELL_LOG_SEVERITY_##severity > ::Stm32Shell::Log::runtimeLevel) {} \
+    else log(::Stm32ItmLogger::LoggerInterface::Severity::severity)
+
+/**
+ * @brief Like LIBSMART_STM32SHELL_LOG(), but logs through the global Stm32ItmLogger::logger.
+ */
+#define LIBSMART_STM32SHELL_LOG_GLOBAL(severity) \
+    if constexpr (!LIBSMART_STM32SHELL_LOG_ENABLED(severity)) {} \
+    else if (LIBSMART_STM32SHELL_LOG_SEVERITY_##severity > ::Stm32Shell::Log::runtimeLevel) {} \
+    else ::Stm32ItmLogger::logger.setSeverity(::Stm32ItmLogger::LoggerInterface::Severity::severity)
+
+namespace Stm32Shell::Log {
+    /** Runtime log level, can only lower the compile time level. */
+    inline uint8_t runtimeLevel = LIBSMART_STM32SHELL_LOG_LEVEL;
+}
+
+#endif
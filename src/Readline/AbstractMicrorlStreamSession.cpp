@@ -4,10 +4,13 @@
  */
 
 #include "AbstractMicrorlStreamSession.hpp"
+#include <algorithm>
 #include <climits>
 #include <microrl.h>
+#include "Command/CommandContext.hpp"
 #include "defines.h"
 #include "Helper.hpp"
+#include "Log.hpp"
 #include "StreamSession/StreamSessionAware.hpp"
 
 microrl_pre_cmd_fn getPreCommandCallbackPointer() {
@@ -32,43 +35,50 @@ void AbstractMicrorlStreamSession::flush() {
 }
 
 int AbstractMicrorlStreamSession::microrlOutputCb(const char *str) {
-    // log(Stm32ItmLogger::LoggerInterface::Severity::DEBUGGING)
+    // LIBSMART_STM32SHELL_LOG(DEBUGGING)
             // ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlOutputCb()");
 
-    write(str);
+    writeEscaped(reinterpret_cast<const uint8_t *>(str), strlen(str));
     return 0;
 }
 
 int AbstractMicrorlStreamSession::microrlExecCb(int argc, const char *const *argv) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlExecCb()");
 
     return executeCallback(argc, argv);
 }
 
 char **AbstractMicrorlStreamSession::microrlCompleteCb(int argc, const char *const *argv) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlCompleteCb()");
 
+    return completeCallback(argc, argv);
+}
+
+char **AbstractMicrorlStreamSession::completeCallback(int argc, const char *const *argv) {
     LIBSMART_UNUSED(argc);
     LIBSMART_UNUSED(argv);
-    return nullptr;
+    static char *noCompletion[] = {nullptr};
+    return noCompletion;
 }
 
 void AbstractMicrorlStreamSession::microrlSigintCb() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlSigintCb()");
+
+    sigintCallback();
 }
 
 void AbstractMicrorlStreamSession::microrlPreCommandCb(int argc, const char *const *argv) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlPreCommandCb()");
     LIBSMART_UNUSED(argc);
     LIBSMART_UNUSED(argv);
 }
 
 void AbstractMicrorlStreamSession::microrlPostCommandCb(int res, int argc, const char *const *argv) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlPostCommandCb()");
     LIBSMART_UNUSED(res);
     LIBSMART_UNUSED(argc);
@@ -76,13 +86,116 @@ void AbstractMicrorlStreamSession::microrlPostCommandCb(int res, int argc, const
 }
 
 void AbstractMicrorlStreamSession::onWriteTx() {
-    if(isInIsr()) return;
+    if (isInIsr()) {
+        // The transport is signalled from loop()
+        txSignalPending.store(true, std::memory_order_release);
+        return;
+    }
     StreamRxTx::onWriteTx();
     sessionOwner->dataReadyTx(this);
 }
 
+size_t AbstractMicrorlStreamSession::receiveFromIsr(const uint8_t *data, const size_t len) {
+    const auto n = isrRx.write(data, len);
+    requestService();
+    return n;
+}
+
+AbstractMicrorlStreamSession::txSpan_t AbstractMicrorlStreamSession::acquireTx(const size_t maxLen) {
+    reclaimTx();
+    if (txAcquired > 0) return {};
+
+    // The span stays at the start of the TX buffer, new output is appended behind it
+    const auto *tx = getTxBuffer();
+    txAcquired = std::min(tx->getLength(), maxLen);
+    return {tx->getStart(), txAcquired};
+}
+
+void AbstractMicrorlStreamSession::commitTx(const size_t len) {
+    // Only the sending context writes txCommitted, so no read-modify-write is needed
+    txCommitted.store(txCommitted.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    // The bytes are removed on the session thread, a command waiting for output space can continue then
+    requestService();
+}
+
+void AbstractMicrorlStreamSession::reclaimTx() {
+    const auto committed = txCommitted.load(std::memory_order_acquire);
+    if (committed == txReclaimed) return;
+
+    const auto len = std::min(committed - txReclaimed, txAcquired);
+    txReclaimed = committed;
+    txAcquired -= len;
+    getTxBuffer()->remove(len);
+
+    // More output was written while the span was in flight
+    if (txAcquired == 0 && getTxBuffer()->getLength() > 0) sessionOwner->dataReadyTx(this);
+}
+
+size_t AbstractMicrorlStreamSession::writeFromIsr(const uint8_t *data, const size_t len) {
+    const auto n = isrTx.write(data, len);
+    txSignalPending.store(true, std::memory_order_release);
+    requestService();
+    return n;
+}
+
+size_t AbstractMicrorlStreamSession::writeEscaped(const uint8_t *data, const size_t len) {
+    if (!telnetNegotiation) return write(data, len);
+
+    static constexpr uint8_t iacIac[] = {TelnetNegotiator::IAC, TelnetNegotiator::IAC};
+    size_t done = 0;
+    while (done < len) {
+        const auto *iac = static_cast<const uint8_t *>(memchr(data + done, TelnetNegotiator::IAC, len - done));
+        const size_t run = iac == nullptr ? len - done : static_cast<size_t>(iac - (data + done));
+        const auto n = run > 0 ? write(data + done, run) : 0;
+        done += n;
+        if (n < run || iac == nullptr) break;
+        if (getTxBuffer()->getRemainingSpace() < sizeof iacIac) break;
+        write(iacIac, sizeof iacIac);
+        done++;
+    }
+    return done;
+}
+
+size_t AbstractMicrorlStreamSession::getTxSpace() {
+    const auto space = getTxBuffer()->getRemainingSpace();
+    return telnetNegotiation ? space / 2 : space;
+}
+
+size_t AbstractMicrorlStreamSession::escapeTx(const size_t len) {
+    if (!telnetNegotiation || len == 0) return len;
+
+    auto *p = getTxBuffer()->getWritePointer();
+    const auto iacs = static_cast<size_t>(std::count(p, p + len, TelnetNegotiator::IAC));
+    if (iacs == 0) return len;
+    if (len + iacs > getTxBuffer()->getRemainingSpace()) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::escapeTx() no space to escape IAC");
+        return len;
+    }
+
+    // From the back, so every byte is moved once
+    for (size_t src = len, dst = len + iacs; src > 0;) {
+        const auto ch = p[--src];
+        p[--dst] = ch;
+        if (ch == TelnetNegotiator::IAC) p[--dst] = ch;
+    }
+    return len + iacs;
+}
+
+bool AbstractMicrorlStreamSession::hasPendingWork() {
+    return getRxBuffer()->getLength() > 0
+           || isrRx.getLength() > 0
+           || (isrTx.getLength() > 0 && getTxBuffer()->getRemainingSpace() > 0)
+           || txSignalPending.load(std::memory_order_acquire)
+           || txCommitted.load(std::memory_order_acquire) != txReclaimed;
+}
+
+Stm32Shell::Command::ClockInterface *AbstractMicrorlStreamSession::getClock() {
+    return Command::CommandContext::getClock();
+}
+
 void AbstractMicrorlStreamSession::setup() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setup()");
 
     // Initialize microrl library
@@ -101,6 +214,15 @@ void AbstractMicrorlStreamSession::setup() {
     setSigintCallback(bounce<AbstractMicrorlStreamSession, decltype(&AbstractMicrorlStreamSession::microrlSigintCb),
         &AbstractMicrorlStreamSession::microrlSigintCb>);
 
+    loadHistory();
+
+    // Offer character at a time mode to telnet clients
+    telnet.reset();
+    telnet.registerOnSendFunction([this](const uint8_t *buf, const size_t len) {
+        this->write(buf, len);
+    });
+    if (telnetNegotiation) telnet.begin();
+
     println();
     print(FIRMWARE_NAME);
     print(F(" v"));
@@ -116,77 +238,228 @@ void AbstractMicrorlStreamSession::setup() {
 }
 
 void AbstractMicrorlStreamSession::loop() {
-    while (available() > 0) {
-        auto ch = read();
+    auto *rx = getRxBuffer();
+    while (rx->getLength() > 0) {
+        const auto len = rx->getLength();
+        processRxSpan(rx->getStart(), len);
+        rx->remove(len);
+    }
 
-        if (iac == 0 && ch == 0xff) {
-            // Enable IAC mode
-            iac++;
-            continue;
-        }
+    // Input received in interrupt context, processed in place
+    for (auto span = isrRx.peek(); span.len > 0; span = isrRx.peek()) {
+        processRxSpan(span.data, span.len);
+        isrRx.remove(span.len);
+    }
 
-        if (iac == 1 && ch == 0xff) {
-            // Second IAC marks a real 0xff byte
-            iac = 0;
-        }
+    // Output sent by a transport with commitTx() from interrupt context
+    reclaimTx();
 
-        if (iac > 0) {
-            // 1 byte commands
-            if (iac == 1 && ch >= 0xf0 && ch <= 0xf9) {
-                iacCmd = ch;
-                iac = 0;
-                iacCmd = 0;
-            }
+    // Output deferred from interrupt context, as much as the TX buffer takes
+    auto *tx = getTxBuffer();
+    for (auto span = isrTx.peek(); span.len > 0 && tx->getRemainingSpace() > 0; span = isrTx.peek()) {
+        isrTx.remove(writeEscaped(span.data, std::min(span.len, tx->getRemainingSpace())));
+    }
+    if (txSignalPending.load(std::memory_order_acquire)) {
+        // Cleared before signalling, so a write from an ISR in between is covered
+        txSignalPending.store(false, std::memory_order_relaxed);
+        sessionOwner->dataReadyTx(this);
+    }
+
+#if MICRORL_CFG_USE_HISTORY
+    if (historyStorage != nullptr
+        && microrl_hist_seq(this) - historySeq >= LIBSMART_STM32SHELL_HISTORY_BATCH_RECORDS) {
+        flushHistory();
+    }
+#endif
+}
 
-            // 2 byte commands
-            if (iac == 1 && ch >= 0xfb && ch <= 0xfe) {
-                iacCmd = ch;
-                iac++;
+namespace {
+    using telnetState = Stm32Shell::Readline::AbstractMicrorlStreamSession::telnetState;
+
+    /** Byte classes relevant for the telnet state machine. */
+    enum telnetByteClass : uint8_t {
+        TBC_DATA,   ///< Any byte below 0xf0
+        TBC_SE,     ///< 0xf0 End of subnegotiation
+        TBC_CMD,    ///< 0xf1..0xf9 One byte commands
+        TBC_SB,     ///< 0xfa Start of subnegotiation
+        TBC_NEG,    ///< 0xfb..0xfe WILL/WONT/DO/DONT
+        TBC_IAC,    ///< 0xff Interpret as command
+        TBC_COUNT
+    };
+
+    /** Side effect of a transition of the telnet state machine. */
+    enum telnetAction : uint8_t {
+        TA_NONE,        ///< Drop the byte
+        TA_EMIT,        ///< Pass the byte to the line editor
+        TA_COMMAND,     ///< Remember the negotiation command
+        TA_OPTION,      ///< Negotiate the option
+        TA_SB_BEGIN,    ///< Start a subnegotiation
+        TA_SB_DATA,     ///< Collect a byte of the subnegotiation
+        TA_SB_END       ///< Complete the subnegotiation
+    };
+
+    struct telnetTransition {
+        telnetState next;
+        telnetAction action;
+    };
+
+    constexpr telnetByteClass telnetClassify(const uint8_t ch) {
+        return ch < 0xf0 ? TBC_DATA
+               : ch == 0xf0 ? TBC_SE
+               : ch <= 0xf9 ? TBC_CMD
+               : ch == 0xfa ? TBC_SB
+               : ch <= 0xfe ? TBC_NEG
+               : TBC_IAC;
+    }
+
+    /** Transition table [state][byte class] of the telnet state machine. */
+    constexpr telnetTransition telnetTable[][TBC_COUNT] = {
+        // DATA
+        {
+            {telnetState::DATA, TA_EMIT}, {telnetState::DATA, TA_EMIT}, {telnetState::DATA, TA_EMIT},
+            {telnetState::DATA, TA_EMIT}, {telnetState::DATA, TA_EMIT}, {telnetState::IAC, TA_NONE}
+        },
+        // IAC
+        {
+            {telnetState::DATA, TA_NONE}, {telnetState::DATA, TA_NONE}, {telnetState::DATA, TA_NONE},
+            {telnetState::SB, TA_SB_BEGIN}, {telnetState::OPTION, TA_COMMAND}, {telnetState::DATA, TA_EMIT}
+        },
+        // OPTION
+        {
+            {telnetState::DATA, TA_OPTION}, {telnetState::DATA, TA_OPTION}, {telnetState::DATA, TA_OPTION},
+            {telnetState::DATA, TA_OPTION}, {telnetState::DATA, TA_OPTION}, {telnetState::DATA, TA_OPTION}
+        },
+        // SB
+        {
+            {telnetState::SB, TA_SB_DATA}, {telnetState::SB, TA_SB_DATA}, {telnetState::SB, TA_SB_DATA},
+            {telnetState::SB, TA_SB_DATA}, {telnetState::SB, TA_SB_DATA}, {telnetState::SB_IAC, TA_NONE}
+        },
+        // SB_IAC
+        {
+            {telnetState::SB, TA_NONE}, {telnetState::DATA, TA_SB_END}, {telnetState::SB, TA_NONE},
+            {telnetState::SB, TA_NONE}, {telnetState::SB, TA_NONE}, {telnetState::SB, TA_SB_DATA}
+        },
+    };
+}
+
+void AbstractMicrorlStreamSession::processRxSpan(const uint8_t *data, const size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        // The start sequence at an empty prompt switches to machine mode
+        if (!machineMode && machineStartLen > 0 && iacState == telnetState::DATA
+            && (machineStartMatched > 0 || cmdlen == 0)) {
+            if (data[pos] == machineStart[machineStartMatched]) {
+                pos++;
+                if (++machineStartMatched == machineStartLen) {
+                    machineStartMatched = 0;
+                    machineMode = true;
+                }
+                continue;
             }
-            if (iac == 2 && iacCmd >= 0xfb && iacCmd <= 0xfe) {
-                iac = 0;
-                iacCmd = 0;
+            if (machineStartMatched > 0) {
+                // Not the sequence, the held back bytes are plain input
+                const auto matched = machineStartMatched;
+                machineStartMatched = 0;
+                processingInput(machineStart, matched);
+                continue;
             }
+        }
 
-            // multi byte commands
-            if (iac == 1 && ch == 0xfa) {
-                iacCmd = ch;
-                iac++;
+        // Machine mode frames bypass telnet and microrl
+        if (machineMode) {
+            pos += machineInput(data + pos, len - pos);
+            if (machineMode) break;
+            continue;
+        }
+
+        if (iacState == telnetState::DATA) {
+            // Fast path: hand everything up to the next IAC to microrl in one call
+            const auto *iacPtr = static_cast<const uint8_t *>(memchr(data + pos, 0xff, len - pos));
+            const size_t run = iacPtr == nullptr ? len - pos : static_cast<size_t>(iacPtr - (data + pos));
+            if (machineStartLen > 0 && run > 1) {
+                // Stop at the first byte of the start sequence, it switches to machine mode if it begins a line
+                const auto *startPtr = static_cast<const uint8_t *>(
+                    memchr(data + pos + 1, machineStart[0], run - 1));
+                if (startPtr != nullptr) {
+                    processingInput(data + pos, static_cast<size_t>(startPtr - (data + pos)));
+                    pos = static_cast<size_t>(startPtr - data);
+                    continue;
+                }
             }
-            // multi byte commands end
-            if (iac > 2 && ch == 0xf0) {
-                iac = 0;
-                iacCmd = 0;
+            if (run > 0) {
+                processingInput(data + pos, run);
+                pos += run;
             }
-        } else {
-            // Send character to microrl, if not in IAC mode
-            processingInput(&ch, 1);
+            if (iacPtr == nullptr) break;
+        }
+
+        const auto ch = data[pos++];
+        const auto &tr = telnetTable[static_cast<uint8_t>(iacState)][telnetClassify(ch)];
+        iacState = tr.next;
+        switch (tr.action) {
+            case TA_NONE:
+                break;
+            case TA_EMIT:
+                processingInput(&ch, 1);
+                break;
+            case TA_COMMAND:
+                telnetCmd = ch;
+                break;
+            case TA_OPTION:
+                telnet.receive(telnetCmd, ch);
+                break;
+            case TA_SB_BEGIN:
+                telnet.beginSubnegotiation();
+                break;
+            case TA_SB_DATA:
+                telnet.subnegotiationByte(ch);
+                break;
+            case TA_SB_END:
+                if (telnet.endSubnegotiation()) {
+                    microrl_set_term_width(this, telnet.getWidth());
+                }
+                break;
         }
     }
 }
 
 void AbstractMicrorlStreamSession::end() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::end()");
 
+    flushHistory();
+
     getRxBuffer()->clear();
     getTxBuffer()->clear();
+    isrRx.clear();
+    isrTx.clear();
+    txSignalPending.store(false, std::memory_order_relaxed);
+    txAcquired = 0;
+    txReclaimed = txCommitted.load(std::memory_order_acquire);
 
     microrl_t{};
-    iac = 0;
-    iacCmd = 0;
+    iacState = telnetState::DATA;
+    telnet.reset();
+    machineMode = false;
+    machineStartMatched = 0;
+}
+
+void AbstractMicrorlStreamSession::setMachineMode(const bool enable) {
+    if (machineMode == enable) return;
+    machineMode = enable;
+    if (!enable) processingInput("\n");
 }
 
 void AbstractMicrorlStreamSession::errorHandler() {
 }
 
 microrlr_t AbstractMicrorlStreamSession::processingInput(const void *data_ptr, size_t len) {
-    // log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    // LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
     //         ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::processingInput()");
 
     const auto ret = microrl_processing_input(this, data_ptr, len);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_processing_input() = 0x%02x\r\n", ret);
     }
     return ret;
@@ -197,29 +470,121 @@ microrlr_t AbstractMicrorlStreamSession::processingInput(const char *c_string) {
 }
 
 microrlr_t AbstractMicrorlStreamSession::setEcho(microrl_echo_t echo) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setEcho()");
 
     const auto ret = microrl_set_echo(this, echo);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_set_echo() = 0x%02x\r\n", ret);
     }
     return ret;
 }
 
 microrlr_t AbstractMicrorlStreamSession::setPrompt(const char *prompt_str) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setPrompt()");
 
     const auto ret = microrl_set_prompt(this, const_cast<char *>(prompt_str));
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_set_prompt() = 0x%02x\r\n", ret);
     }
     return ret;
 }
 
+void AbstractMicrorlStreamSession::setHistoryStorage(HistoryStorageInterface *storage) {
+    historyStorage = storage;
+}
+
+bool AbstractMicrorlStreamSession::flushHistory() {
+#if MICRORL_CFG_USE_HISTORY
+    if (historyStorage == nullptr) return true;
+
+    const auto seq = microrl_hist_seq(this);
+    size_t count = seq - historySeq;
+    if (count == 0) return true;
+    const auto records = microrl_hist_records(this);
+    if (count > records) count = records;
+
+    // Size of the new records in the log
+    char line[MICRORL_CFG_CMDLINE_LEN + 1];
+    size_t bytes = 0;
+    for (size_t age = 1; age <= count; age++) {
+        bytes += microrl_hist_get(this, age, line, sizeof(line)) + 1;
+    }
+
+    if (historyStorage->size() + bytes > historyStorage->capacity()) {
+        // Log is full, start over with the current history
+        LIBSMART_STM32SHELL_LOG(NOTICE)
+                ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::flushHistory() rewrite");
+        if (!historyStorage->erase()) return false;
+        count = records;
+    }
+
+    if (!storeHistory(count)) {
+        LIBSMART_STM32SHELL_LOG(ERROR)
+                ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::flushHistory() failed");
+        return false;
+    }
+    historySeq = seq;
+#endif
+    return true;
+}
+
+void AbstractMicrorlStreamSession::loadHistory() {
+#if MICRORL_CFG_USE_HISTORY
+    if (historyStorage != nullptr) {
+        char line[MICRORL_CFG_CMDLINE_LEN];
+        size_t lineLen = 0;
+        bool overlong = false;
+        char chunk[32];
+        size_t offset = 0;
+        size_t len;
+        while ((len = historyStorage->read(offset, chunk, sizeof(chunk))) > 0) {
+            offset += len;
+            for (size_t i = 0; i < len; i++) {
+                if (chunk[i] == '\n') {
+                    if (!overlong && lineLen > 0) {
+                        microrl_hist_add(this, line, lineLen);
+                    }
+                    lineLen = 0;
+                    overlong = false;
+                } else if (lineLen < sizeof(line)) {
+                    line[lineLen++] = chunk[i];
+                } else {
+                    overlong = true;
+                }
+            }
+        }
+        // An unterminated last record is the remainder of an interrupted write and is dropped
+    }
+    historySeq = microrl_hist_seq(this);
+#endif
+}
+
+bool AbstractMicrorlStreamSession::storeHistory(const size_t count) {
+#if MICRORL_CFG_USE_HISTORY
+    // Collect the records in a batch buffer to keep the number of writes low
+    char batch[2 * (MICRORL_CFG_CMDLINE_LEN + 1)];
+    size_t batchLen = 0;
+    for (size_t age = count; age > 0; age--) {
+        if (sizeof(batch) - batchLen < MICRORL_CFG_CMDLINE_LEN + 1) {
+            if (!historyStorage->append(batch, batchLen)) return false;
+            batchLen = 0;
+        }
+        const auto len = microrl_hist_get(this, age, batch + batchLen, sizeof(batch) - batchLen);
+        if (len == 0) continue;
+        batchLen += len;
+        batch[batchLen++] = '\n';
+    }
+    return batchLen == 0 || historyStorage->append(batch, batchLen);
+#else
+    LIBSMART_UNUSED(count);
+    return true;
+#endif
+}
+
 microrl_pre_cmd_fn AbstractMicrorlStreamSession::getPreCommandCallback() {
     return bounce<AbstractMicrorlStreamSession,
         decltype(&AbstractMicrorlStreamSession::microrlPreCommandCb),
@@ -235,25 +600,25 @@ microrl_post_cmd_fn AbstractMicrorlStreamSession::getPostCommandCallback() {
 }
 
 microrlr_t AbstractMicrorlStreamSession::microrlInit(microrl_output_fn out_fn, microrl_exec_fn exec_fn) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::microrlInit()");
 
     /* Initialize library with microrl instance and print and execute callbacks */
     const auto ret = microrl_init(this, out_fn, exec_fn);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_init() = 0x%02x\r\n", ret);
     }
     return ret;
 }
 
 microrlr_t AbstractMicrorlStreamSession::setExecuteCallback(microrl_exec_fn exec_fn) {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setExecuteCallback()");
 
     const auto ret = microrl_set_execute_callback(this, exec_fn);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_set_execute_callback() = 0x%02x\r\n", ret);
     }
     return ret;
@@ -261,12 +626,12 @@ microrlr_t AbstractMicrorlStreamSession::setExecuteCallback(microrl_exec_fn exec
 
 microrlr_t AbstractMicrorlStreamSession::setCompleteCallback(microrl_get_compl_fn get_completion_fn) {
 #if MICRORL_CFG_USE_COMPLETE
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setCompleteCallback()");
 
     const auto ret = microrl_set_complete_callback(this, get_completion_fn);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_set_complete_callback() = 0x%02x\r\n", ret);
     }
     return ret;
@@ -277,12 +642,12 @@ microrlr_t AbstractMicrorlStreamSession::setCompleteCallback(microrl_get_compl_f
 
 microrlr_t AbstractMicrorlStreamSession::setSigintCallback(microrl_sigint_fn sigint_fn) {
 #if MICRORL_CFG_USE_CTRL_C
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::setSigintCallback()");
 
     const auto ret = microrl_set_sigint_callback(this, sigint_fn);
     if (ret != microrlOK) {
-        log(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32SHELL_LOG(ERROR)
                 ->printf("microrl_set_sigint_callback() = 0x%02x\r\n", ret);
     }
     return ret;
@@ -292,7 +657,7 @@ microrlr_t AbstractMicrorlStreamSession::setSigintCallback(microrl_sigint_fn sig
 }
 
 uint32_t AbstractMicrorlStreamSession::getVersion() {
-    log(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::Readline::AbstractMicrorlStreamSession::getVersion()");
 
     return microrl_get_version();
@@ -9,9 +9,24 @@
 #include <libsmart_config.hpp>
 #include <microrl.h>
 #include <StreamSession/StreamSessionInterface.hpp>
+#include "Command/ClockInterface.hpp"
+#include "HistoryStorageInterface.hpp"
+#include "SessionSchedulerInterface.hpp"
+#include "SpscRing.hpp"
+#include "TelnetNegotiator.hpp"
 #include "Loggable.hpp"
 #include "StreamRxTx.hpp"
 
+/** Size of the lock-free ring for input in interrupt context, a power of two */
+#ifndef LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_RX
+#define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_RX 64
+#endif
+
+/** Size of the lock-free ring for output in interrupt context, a power of two */
+#ifndef LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_TX
+#define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_TX 64
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -21,6 +36,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 namespace Stm32Shell::Readline {
+    template<class T, size_t N>
     class Server;
 
     /**
@@ -39,7 +55,20 @@ namespace Stm32Shell::Readline {
                                              LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_BUFFER_SIZE_RX,
                                              LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_BUFFER_SIZE_TX> {
     public:
-        friend Server;
+        template<class T, size_t N>
+        friend class Server;
+
+        /**
+         * @brief States of the telnet IAC (Interpret As Command) state machine.
+         */
+        using u_telnetState = enum class telnetState : uint8_t {
+            DATA,       ///< Plain data
+            IAC,        ///< IAC received, waiting for the command byte
+            OPTION,     ///< WILL/WONT/DO/DONT received, waiting for the option byte
+            SB,         ///< Inside a subnegotiation
+            SB_IAC      ///< IAC received inside a subnegotiation
+        };
+
 
         AbstractMicrorlStreamSession() : microrl_t() { ; }
 
@@ -122,6 +151,151 @@ namespace Stm32Shell::Readline {
          */
         static microrl_post_cmd_fn getPostCommandCallback();
 
+        /**
+         * @brief Sets the persistent storage for the command history.
+         *
+         * Must be set before setup(), which loads the stored history. New records
+         * are appended to the storage in batches of LIBSMART_STM32SHELL_HISTORY_BATCH_RECORDS
+         * and when the session ends.
+         *
+         * @param storage The history storage, or nullptr to keep the history in RAM only.
+         */
+        void setHistoryStorage(HistoryStorageInterface *storage);
+
+        /**
+         * @brief Appends all history records which are not stored yet to the history storage.
+         *
+         * If the storage is full, it is erased and rewritten with the whole history.
+         *
+         * @return true on success or if there is no history storage.
+         */
+        bool flushHistory();
+
+        /**
+         * @brief Enables the telnet option negotiation at session start.
+         *
+         * Must be set before setup(). Only enable it for telnet connections, a
+         * plain serial terminal would print the negotiation bytes. Negotiations
+         * started by the client are answered in any case.
+         *
+         * @param enable true to offer character at a time mode to the client.
+         */
+        void setTelnetNegotiation(const bool enable) { telnetNegotiation = enable; }
+
+        /** @return Terminal width reported by the telnet client, 0 if unknown. */
+        uint16_t getTerminalWidth() const { return telnet.getWidth(); }
+
+        /** @return Terminal height reported by the telnet client, 0 if unknown. */
+        uint16_t getTerminalHeight() const { return telnet.getHeight(); }
+
+        /** @return The telnet option negotiation of this session. */
+        const TelnetNegotiator &getTelnetNegotiator() const { return telnet; }
+
+        /**
+         * @brief Output of the session, readable in place by a transport.
+         */
+        struct txSpan_t {
+            const uint8_t *data = nullptr;  ///< Start of the bytes to send
+            size_t len = 0;                 ///< Number of bytes to send
+        };
+
+        /**
+         * @brief Takes the pending output for sending without a copy.
+         *
+         * For transports that send from memory, e.g. UART DMA or a network stack
+         * with zero-copy packets. The span points into the TX buffer and stays
+         * valid until commitTx(), output written meanwhile is appended behind it.
+         * Only one span can be in flight, the next call returns an empty span
+         * until the previous one has been committed.
+         *
+         * Must be called on the session thread, i.e. from loop() or dataReadyTx(),
+         * as it removes committed bytes from the TX buffer.
+         *
+         * @param maxLen Maximum number of bytes, e.g. the size of a packet.
+         * @return The bytes to send, len is 0 if there is nothing to send.
+         */
+        txSpan_t acquireTx(size_t maxLen = SIZE_MAX);
+
+        /**
+         * @brief Releases sent bytes of the span returned by acquireTx().
+         *
+         * Can be called from any thread or from interrupt context, e.g. from the
+         * DMA transfer complete callback. It only records the bytes and requests
+         * service, they are removed from the TX buffer on the session thread by
+         * the next loop() or acquireTx().
+         *
+         * @param len Number of bytes sent, at most the length of the span.
+         */
+        void commitTx(size_t len);
+
+        /**
+         * @brief Queues received bytes from interrupt context.
+         *
+         * For transports that receive in an ISR or DMA callback. The bytes go
+         * to a lock-free ring which loop() processes in place. Safe while
+         * loop() runs, as long as only one context calls this method.
+         *
+         * @param data Received bytes.
+         * @param len  Number of bytes.
+         * @return Number of bytes queued, less than len if the ring is full.
+         */
+        size_t receiveFromIsr(const uint8_t *data, size_t len);
+
+        /**
+         * @brief Queues output from interrupt context.
+         *
+         * write() and print() must not be used in an ISR, they share the TX
+         * buffer with the session. The bytes go to a lock-free ring, loop()
+         * moves them to the TX buffer and signals the transport. Safe while
+         * loop() runs, as long as only one context calls this method.
+         *
+         * @param data Bytes to send.
+         * @param len  Number of bytes.
+         * @return Number of bytes queued, less than len if the ring is full.
+         */
+        size_t writeFromIsr(const uint8_t *data, size_t len);
+
+        /**
+         * @brief Reports that the session needs a call to loop().
+         *
+         * Transports writing to the RX buffer or reading from the TX buffer
+         * directly call it after each access. receiveFromIsr(), writeFromIsr()
+         * and commitTx() call it themselves. Can be called from interrupt context. Does nothing if
+         * the session is not served by a scheduler.
+         */
+        void requestService() {
+            if (auto *s = scheduler.load(std::memory_order_acquire)) s->markReady(this);
+        }
+
+        /**
+         * @brief Checks if loop() still has work to do after it returned.
+         *
+         * A scheduler keeps such a session runnable instead of waiting for
+         * the next event. Work that waits for an event, e.g. output waiting
+         * for space in the TX buffer, does not count, the event is reported
+         * with requestService().
+         *
+         * @return true if input or output from interrupt context is pending.
+         */
+        virtual bool hasPendingWork();
+
+        /**
+         * @brief Returns the time until loop() must be called, even without an event.
+         *
+         * A scheduler waits at most this long, e.g. for a command in a delay
+         * or for its run timeout.
+         *
+         * @param now Current time of the command clock [us].
+         * @return Time [us], 0 if due, UINT32_MAX without deadline. The default has none.
+         */
+        virtual uint32_t getTimeToDeadline(const uint32_t now) {
+            (void) now;
+            return UINT32_MAX;
+        }
+
+        /** @return The clock of getTimeToDeadline(), the command clock. */
+        static Command::ClockInterface *getClock();
+
     protected:
         /**
          * @brief Initializes the microrl library with provided output and execute callbacks.
@@ -203,6 +377,99 @@ namespace Stm32Shell::Readline {
          */
         virtual int executeCallback(int argc, const char *const *argv) = 0;
 
+        /**
+         * @brief Provides completion candidates for the current input.
+         *
+         * Called every time the user presses TAB. The returned array must stay valid
+         * until the next call and be terminated by nullptr.
+         *
+         * @param argc Number of tokens up to the cursor, the last one is the token to complete.
+         * @param argv Tokens up to the cursor.
+         * @return nullptr terminated array of candidates. The default returns an empty list.
+         */
+        virtual char **completeCallback(int argc, const char *const *argv);
+
+        /**
+         * @brief Called every time the user presses Ctrl+C.
+         *
+         * Derived classes can override this method to terminate a running command.
+         * The default implementation does nothing.
+         */
+        virtual void sigintCallback() {
+        };
+
+        /**
+         * @brief Called with the received bytes while the session is in machine mode.
+         *
+         * In machine mode, the bytes bypass the telnet state machine and microrl. The
+         * default implementation drops them.
+         *
+         * @param data Received bytes.
+         * @param len  Number of received bytes.
+         * @return Number of bytes consumed. Less than len if machine mode has been
+         *         switched off, the rest goes to the line editor.
+         */
+        virtual size_t machineInput(const uint8_t *data, size_t len) {
+            (void) data;
+            return len;
+        }
+
+        /**
+         * @brief Enables switching to machine mode by the client.
+         *
+         * If the sequence is received while the command line is empty, the session
+         * switches to machine mode and passes all following input to machineInput().
+         * The bytes of a partial match are held back, and go to the line editor
+         * if the sequence does not complete. The sequence must not contain 0xff.
+         *
+         * @param sequence Bytes that switch to machine mode, must stay valid. nullptr to disable switching.
+         * @param len      Number of bytes of the sequence.
+         */
+        void setMachineModeStart(const uint8_t *sequence, const size_t len) {
+            machineStart = sequence;
+            machineStartLen = sequence == nullptr ? 0 : len;
+            machineStartMatched = 0;
+        }
+
+        /**
+         * @brief Switches machine mode on or off.
+         *
+         * Switching off returns to the line editor and prints the prompt.
+         */
+        void setMachineMode(bool enable);
+
+        /** @return true while the session is in machine mode. */
+        bool isMachineMode() const { return machineMode; }
+
+        /**
+         * @brief Writes data to the TX buffer, with 0xff doubled to IAC IAC for telnet.
+         *
+         * Telnet requires a data byte 0xff to be sent twice. The bytes are doubled
+         * while telnet negotiation is enabled. Machine mode frames bypass telnet, like
+         * on the receiving side, and are not escaped.
+         *
+         * @return Number of bytes of data written, less than len if the TX buffer is full.
+         */
+        size_t writeEscaped(const uint8_t *data, size_t len);
+
+        /**
+         * @return Number of bytes that can be written at the write pointer of the TX buffer
+         *         and still fit after escapeTx(). Half the free space while telnet negotiation
+         *         is enabled, as every byte may be doubled.
+         */
+        size_t getTxSpace();
+
+        /**
+         * @brief Doubles 0xff to IAC IAC in bytes written at the write pointer of the TX buffer.
+         *
+         * For output written into the TX buffer in place, before it is committed with
+         * setWrittenBytes(). Does nothing unless telnet negotiation is enabled.
+         *
+         * @param len Number of bytes written at the write pointer, at most getTxSpace().
+         * @return Number of bytes to commit.
+         */
+        size_t escapeTx(size_t len);
+
     private:
         /**
          * @brief Output function for microrl library
@@ -279,13 +546,77 @@ namespace Stm32Shell::Readline {
 
 
         /**
-         * @brief Variable to store the state of the IAC (Interpret As Command) byte in Telnet protocol.
+         * @brief Feeds a span of received bytes into microrl.
+         *
+         * Contiguous runs of plain data are handed to processingInput() in a single
+         * call. Telnet IAC sequences in between are handled by the telnet state machine,
+         * option negotiations are passed to the TelnetNegotiator.
+         *
+         * @param data Pointer to the received bytes.
+         * @param len  Number of bytes in the span.
+         */
+        void processRxSpan(const uint8_t *data, size_t len);
+
+        /**
+         * @brief Removes the bytes committed by the transport from the TX buffer.
+         *
+         * Session thread only, it modifies the TX buffer.
+         */
+        void reclaimTx();
+
+        /**
+         * @brief Loads the command history from the history storage.
+         */
+        void loadHistory();
+
+        /**
+         * @brief Appends the newest records of the history to the history storage.
          *
-         * This variable holds the value of the IAC byte, which is used to signal that the following bytes
-         * represent a command rather than data. It is an 8-bit unsigned integer initialized to zero.
+         * @param count Number of records to append, oldest first.
+         * @return true on success.
          */
-        uint8_t iac{};
-        uint8_t iacCmd{};
+        bool storeHistory(size_t count);
+
+        /** Current state of the telnet IAC state machine. */
+        telnetState iacState = telnetState::DATA;
+        /** WILL/WONT/DO/DONT of the negotiation being received. */
+        uint8_t telnetCmd = 0;
+        /** Option negotiation with a telnet client. */
+        TelnetNegotiator telnet;
+        /** true: offer character at a time mode in setup(). */
+        bool telnetNegotiation = false;
+
+        /** Input from receiveFromIsr(), the ISR produces, loop() consumes. */
+        SpscRing<LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_RX> isrRx;
+        /** Output from writeFromIsr(), the ISR produces, loop() consumes. */
+        SpscRing<LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_TX> isrTx;
+        /** Set in interrupt context if the transport must be signalled by loop(). */
+        std::atomic<bool> txSignalPending{false};
+
+        /** Bytes at the start of the TX buffer handed to the transport by acquireTx(). */
+        size_t txAcquired = 0;
+        /** Total of all bytes committed by the transport, written by commitTx() only. */
+        std::atomic<size_t> txCommitted{0};
+        /** Value of txCommitted whose bytes have been removed from the TX buffer. */
+        size_t txReclaimed = 0;
+
+        /** true: received bytes go to machineInput(). */
+        bool machineMode = false;
+        /** Sequence that switches to machine mode, nullptr if the session cannot switch. */
+        const uint8_t *machineStart = nullptr;
+        /** Length of machineStart. */
+        size_t machineStartLen = 0;
+        /** Bytes of machineStart received so far. */
+        size_t machineStartMatched = 0;
+
+        /** Scheduler to report events to, nullptr if loop() is polled. */
+        std::atomic<SessionSchedulerInterface *> scheduler{nullptr};
+
+        /** Persistent storage for the command history, may be nullptr. */
+        HistoryStorageInterface *historyStorage = nullptr;
+
+        /** Value of microrl_hist_seq() when the history storage was last written. */
+        uint32_t historySeq = 0;
 
     protected:
         void onWriteTx() override;
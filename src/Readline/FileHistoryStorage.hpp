@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_FILEHISTORYSTORAGE_HPP
+#define LIBSMART_STM32SHELL_READLINE_FILEHISTORYSTORAGE_HPP
+
+#include <cstdio>
+#include "HistoryStorageInterface.hpp"
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief History storage in a file.
+     *
+     * Stand-in for a flash sector when running on a host, or for targets
+     * with a file system. The file is opened for every operation, so it
+     * can be inspected while the shell is running.
+     */
+    class FileHistoryStorage : public HistoryStorageInterface {
+    public:
+        /**
+         * @param path     Path of the history file.
+         * @param capacity Maximum size of the file in bytes.
+         */
+        FileHistoryStorage(const char *path, const size_t capacity) : path(path), cap(capacity) { ; }
+
+        size_t read(const size_t offset, char *buf, const size_t len) override {
+            FILE *f = fopen(path, "rb");
+            if (f == nullptr) return 0;
+            size_t ret = 0;
+            if (fseek(f, static_cast<long>(offset), SEEK_SET) == 0) {
+                ret = fread(buf, 1, len, f);
+            }
+            fclose(f);
+            return ret;
+        }
+
+        bool append(const char *data, const size_t len) override {
+            if (size() + len > cap) return false;
+            FILE *f = fopen(path, "ab");
+            if (f == nullptr) return false;
+            const bool ret = fwrite(data, 1, len, f) == len;
+            return fclose(f) == 0 && ret;
+        }
+
+        bool erase() override {
+            FILE *f = fopen(path, "wb");
+            if (f == nullptr) return false;
+            return fclose(f) == 0;
+        }
+
+        size_t size() override {
+            FILE *f = fopen(path, "rb");
+            if (f == nullptr) return 0;
+            long ret = -1;
+            if (fseek(f, 0, SEEK_END) == 0) {
+                ret = ftell(f);
+            }
+            fclose(f);
+            return ret < 0 ? 0 : static_cast<size_t>(ret);
+        }
+
+        size_t capacity() override {
+            return cap;
+        }
+
+    private:
+        const char *path;
+        const size_t cap;
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_HISTORYSTORAGEINTERFACE_HPP
+#define LIBSMART_STM32SHELL_READLINE_HISTORYSTORAGEINTERFACE_HPP
+
+#include <cstddef>
+
+/** Number of new history records collected before they are appended to the storage in one batch */
+#ifndef LIBSMART_STM32SHELL_HISTORY_BATCH_RECORDS
+#define LIBSMART_STM32SHELL_HISTORY_BATCH_RECORDS 8
+#endif
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Append-only storage for the command history.
+     *
+     * The history is stored as a log of records, each terminated by '\n'.
+     * Records are only ever appended, in batches of
+     * LIBSMART_STM32SHELL_HISTORY_BATCH_RECORDS, so a flash backend writes
+     * each byte once until the log is full. Then the log is erased and
+     * rewritten with the records that are still in the history.
+     */
+    class HistoryStorageInterface {
+    public:
+        virtual ~HistoryStorageInterface() = default;
+
+        /**
+         * @brief Reads from the log.
+         *
+         * @param offset Position in the log to read from.
+         * @param buf    Buffer to read into.
+         * @param len    Maximum number of bytes to read.
+         * @return Number of bytes read, 0 at the end of the log.
+         */
+        virtual size_t read(size_t offset, char *buf, size_t len) = 0;
+
+        /**
+         * @brief Appends data at the end of the log.
+         *
+         * @param data Data to append.
+         * @param len  Number of bytes to append.
+         * @return true on success.
+         */
+        virtual bool append(const char *data, size_t len) = 0;
+
+        /**
+         * @brief Erases the whole log.
+         *
+         * @return true on success.
+         */
+        virtual bool erase() = 0;
+
+        /**
+         * @brief Current length of the log in bytes.
+         */
+        virtual size_t size() = 0;
+
+        /**
+         * @brief Maximum length of the log in bytes.
+         */
+        virtual size_t capacity() = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_HOSTWAKEUP_HPP
+#define LIBSMART_STM32SHELL_READLINE_HOSTWAKEUP_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "WakeupInterface.hpp"
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Wakeup based on std::condition_variable, for running on a host.
+     *
+     * notify() can be called from any thread, e.g. a socket reader.
+     */
+    class HostWakeup : public WakeupInterface {
+    public:
+        void notify() override {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending = true;
+            }
+            cv.notify_one();
+        }
+
+        bool wait(const uint32_t timeoutUs) override {
+            std::unique_lock<std::mutex> lock(mutex);
+            const bool notified = cv.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] { return pending; });
+            pending = false;
+            return notified;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool pending = false;
+    };
+}
+
+#endif
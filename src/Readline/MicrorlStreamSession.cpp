@@ -4,13 +4,14 @@
  */
 
 #include "MicrorlStreamSession.hpp"
+#include "Log.hpp"
 
 int Stm32Shell::Readline::MicrorlStreamSession::executeCallback(int argc, const char *const *argv) {
-    log()->print("Tokens found: ");
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)->print("Tokens found: ");
     for (int i = 0; i < argc; i++) {
-        log()->printf("{%s} ", argv[i]);
+        LIBSMART_STM32SHELL_LOG(INFORMATIONAL)->printf("{%s} ", argv[i]);
     }
-    log()->println();
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)->println();
 
     return 0;
 }
@@ -0,0 +1,199 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_SERVER_HPP
+#define LIBSMART_STM32SHELL_READLINE_SERVER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include "Command/ClockInterface.hpp"
+#include "SessionSchedulerInterface.hpp"
+#include "WakeupInterface.hpp"
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Serves up to N sessions from a fixed pool.
+     *
+     * All session objects are allocated statically with the server. A transport
+     * (telnet listener, UART, ...) calls open() for every new client and close()
+     * when the client is gone. loop() services the open sessions round-robin,
+     * each session gets one loop() call per pass. The session that is serviced
+     * first rotates, so a busy client can not starve the others.
+     *
+     * With a wakeup set by setWakeup(), the server is event-driven: loop()
+     * only services sessions that reported an event with requestService(),
+     * that made progress in their last loop() and still have work to do, or
+     * whose deadline has expired. A command waiting for output space or in a
+     * delay does not keep its session runnable. The serving thread blocks in
+     * waitForWork() in between, at most until the next deadline, so idle
+     * sessions cost nothing and received bytes are processed as soon as they
+     * arrive:
+     *
+     *   while (true) {
+     *       server.waitForWork(100000);
+     *       server.loop();
+     *   }
+     *
+     * Use HostWakeup on a host and ThreadXWakeup on the target. Without a
+     * wakeup, loop() polls every open session as before.
+     *
+     * @tparam T Session type, derived from AbstractMicrorlStreamSession.
+     * @tparam N Maximum number of concurrent sessions.
+     */
+    template<class T, size_t N>
+    class Server : public SessionSchedulerInterface {
+        static_assert(std::is_base_of_v<AbstractMicrorlStreamSession, T>,
+                      "T must be derived from AbstractMicrorlStreamSession");
+
+    public:
+        /**
+         * @brief Takes a session from the pool and sets it up.
+         *
+         * @return The new session, or nullptr if all sessions are in use.
+         */
+        T *open() {
+            for (size_t i = 0; i < N; i++) {
+                if (!used[i]) {
+                    used[i] = true;
+                    sessions[i].scheduler.store(this, std::memory_order_release);
+                    sessions[i].setup();
+                    markReady(i);
+                    return &sessions[i];
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Ends a session and returns it to the pool.
+         *
+         * @param session A session returned by open().
+         */
+        void close(T *session) {
+            const auto i = indexOf(session);
+            if (i >= N || !used[i]) return;
+            sessions[i].end();
+            sessions[i].scheduler.store(nullptr, std::memory_order_release);
+            ready[i].store(false, std::memory_order_relaxed);
+            used[i] = false;
+        }
+
+        /**
+         * @brief Services the open sessions once, starting with the next one in turn.
+         *
+         * Without a wakeup all open sessions are serviced, otherwise only the
+         * runnable ones.
+         */
+        void loop() {
+            // Keeps a cycle counter based clock in step, also while all sessions wait
+            const auto now = T::getClock()->micros();
+            for (size_t n = 0; n < N; n++) {
+                const auto i = (next + n) % N;
+                if (!used[i]) continue;
+                if (wakeup != nullptr) {
+                    if (!ready[i].load(std::memory_order_acquire) && sessions[i].getTimeToDeadline(now) > 0) continue;
+                    // Cleared before servicing, so an event in between is covered
+                    ready[i].store(false, std::memory_order_relaxed);
+                }
+                sessions[i].loop();
+                if (sessions[i].hasPendingWork()) ready[i].store(true, std::memory_order_relaxed);
+            }
+            next = (next + 1) % N;
+        }
+
+        /**
+         * @brief Blocks until a session is runnable or its deadline has expired.
+         *
+         * Returns at once if a session is runnable already or no wakeup is set.
+         * The wait ends at the latest at the nearest deadline of a session.
+         *
+         * loop() and waitForWork() read T::getClock() on every call, also
+         * if no session is serviced. A CycleCounterClock must be read at least
+         * once per cycle counter period, so keep timeoutUs well below it.
+         *
+         * @param timeoutUs Maximum time to wait [us].
+         * @return true if a session is runnable, false on timeout.
+         */
+        bool waitForWork(uint32_t timeoutUs) {
+            auto *clock = T::getClock();
+            const auto now = clock->micros();
+            if (wakeup == nullptr || hasReady()) return true;
+            timeoutUs = std::min(timeoutUs, timeToDeadline(now));
+            if (timeoutUs == 0) return true;
+            wakeup->wait(timeoutUs);
+            return hasReady() || timeToDeadline(clock->micros()) == 0;
+        }
+
+        /**
+         * @brief Sets the wakeup for event-driven operation.
+         *
+         * @param w The wakeup, or nullptr to poll all open sessions in loop().
+         */
+        void setWakeup(WakeupInterface *w) { wakeup = w; }
+
+        void markReady(AbstractMicrorlStreamSession *session) override {
+            for (size_t i = 0; i < N; i++) {
+                if (static_cast<AbstractMicrorlStreamSession *>(&sessions[i]) == session) {
+                    markReady(i);
+                    return;
+                }
+            }
+        }
+
+        /** @return Number of open sessions. */
+        size_t size() const {
+            size_t count = 0;
+            for (const auto u: used) {
+                if (u) count++;
+            }
+            return count;
+        }
+
+        /** @return Maximum number of sessions. */
+        static constexpr size_t capacity() { return N; }
+
+    private:
+        std::array<T, N> sessions{};
+        std::array<bool, N> used{};
+        /** Set by events from any context, cleared by loop(). */
+        std::array<std::atomic<bool>, N> ready{};
+        /** Wakes waitForWork(), nullptr to poll. */
+        WakeupInterface *wakeup = nullptr;
+        size_t next = 0;
+
+        void markReady(const size_t i) {
+            ready[i].store(true, std::memory_order_release);
+            if (wakeup != nullptr) wakeup->notify();
+        }
+
+        bool hasReady() const {
+            for (size_t i = 0; i < N; i++) {
+                if (used[i] && ready[i].load(std::memory_order_acquire)) return true;
+            }
+            return false;
+        }
+
+        /** @return Time [us] until the nearest deadline of an open session, UINT32_MAX if there is none. */
+        uint32_t timeToDeadline(const uint32_t now) {
+            uint32_t timeout = UINT32_MAX;
+            for (size_t i = 0; i < N; i++) {
+                if (used[i]) timeout = std::min(timeout, sessions[i].getTimeToDeadline(now));
+            }
+            return timeout;
+        }
+
+        size_t indexOf(const T *session) const {
+            for (size_t i = 0; i < N; i++) {
+                if (&sessions[i] == session) return i;
+            }
+            return N;
+        }
+    };
+}
+
+#endif
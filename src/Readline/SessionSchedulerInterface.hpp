@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_SESSIONSCHEDULERINTERFACE_HPP
+#define LIBSMART_STM32SHELL_READLINE_SESSIONSCHEDULERINTERFACE_HPP
+
+namespace Stm32Shell::Readline {
+    class AbstractMicrorlStreamSession;
+
+    /**
+     * @brief Services sessions only when they have something to do.
+     *
+     * A session reports each event that needs its loop(), e.g. received
+     * bytes or a freed TX buffer, with markReady().
+     */
+    class SessionSchedulerInterface {
+    public:
+        virtual ~SessionSchedulerInterface() = default;
+
+        /**
+         * @brief Marks a session runnable. Can be called from interrupt context.
+         *
+         * @param session The session that needs a call to loop().
+         */
+        virtual void markReady(AbstractMicrorlStreamSession *session) = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_SPSCRING_HPP
+#define LIBSMART_STM32SHELL_READLINE_SPSCRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Lock-free byte ring for exactly one producer and one consumer.
+     *
+     * Producer and consumer may run in different contexts, e.g. a UART
+     * interrupt and the session thread, without disabling interrupts. Each
+     * index is written by one side only. The producer publishes new bytes
+     * with a release store of the write index, the consumer frees space
+     * with a release store of the read index. Each side reads the index of
+     * the other side with acquire, so the payload is always visible before
+     * the index that covers it.
+     *
+     * Only loads and stores of the indices are used, no read-modify-write,
+     * so the ring is lock-free on every core with naturally atomic 32 bit
+     * accesses, including Cortex-M0.
+     *
+     * @tparam N Capacity in bytes, a power of two.
+     */
+    template<size_t N>
+    class SpscRing {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+    public:
+        /** A contiguous part of the ring content. */
+        struct span_t {
+            const uint8_t *data;
+            size_t len;
+        };
+
+        /**
+         * @brief Appends bytes. Producer side only.
+         *
+         * @param data Bytes to append.
+         * @param len  Number of bytes.
+         * @return Number of bytes appended, less than len if the ring is full.
+         */
+        size_t write(const uint8_t *data, const size_t len) {
+            const auto t = tail.load(std::memory_order_relaxed);
+            const auto h = head.load(std::memory_order_acquire);
+            const auto n = len < N - (t - h) ? len : N - (t - h);
+
+            const auto off = t & (N - 1);
+            const auto first = n < N - off ? n : N - off;
+            memcpy(buf + off, data, first);
+            memcpy(buf, data + first, n - first);
+
+            tail.store(t + n, std::memory_order_release);
+            return n;
+        }
+
+        /** @return Free space in bytes. Exact on the producer side. */
+        size_t getRemainingSpace() const {
+            return N - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+        }
+
+        /** @return Number of bytes in the ring. Exact on the consumer side. */
+        size_t getLength() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Returns the oldest contiguous part of the content. Consumer side only.
+         *
+         * The bytes stay valid until they are removed. If the content wraps
+         * around the end of the ring, call again after remove() for the rest.
+         */
+        span_t peek() const {
+            const auto h = head.load(std::memory_order_relaxed);
+            const auto len = tail.load(std::memory_order_acquire) - h;
+            const auto off = h & (N - 1);
+            return {buf + off, len < N - off ? len : N - off};
+        }
+
+        /**
+         * @brief Removes the oldest bytes. Consumer side only.
+         *
+         * @param len Number of bytes, at most getLength().
+         */
+        void remove(const size_t len) {
+            head.store(head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+        }
+
+        /**
+         * @brief Copies and removes the oldest bytes. Consumer side only.
+         *
+         * @return Number of bytes read.
+         */
+        size_t read(uint8_t *out, const size_t len) {
+            size_t n = 0;
+            while (n < len) {
+                const auto span = peek();
+                if (span.len == 0) break;
+                const auto chunk = span.len < len - n ? span.len : len - n;
+                memcpy(out + n, span.data, chunk);
+                remove(chunk);
+                n += chunk;
+            }
+            return n;
+        }
+
+        /** @brief Drops the content. Consumer side only. */
+        void clear() {
+            head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        /** @return Capacity in bytes. */
+        static constexpr size_t capacity() { return N; }
+
+    private:
+        uint8_t buf[N] = {};
+        /** Free running read index, written by the consumer. */
+        std::atomic<size_t> head{0};
+        /** Free running write index, written by the producer. */
+        std::atomic<size_t> tail{0};
+    };
+}
+
+#endif
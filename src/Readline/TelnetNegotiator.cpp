@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "TelnetNegotiator.hpp"
+
+using namespace Stm32Shell::Readline;
+
+namespace {
+    using option = TelnetNegotiator::option;
+
+    /** Supported options, the index is used for the state arrays. */
+    constexpr option supportedOptions[] = {option::BINARY, option::ECHO, option::SGA, option::NAWS};
+}
+
+void TelnetNegotiator::begin() {
+    request(option::ECHO, side::LOCAL, true);
+    request(option::SGA, side::LOCAL, true);
+    request(option::BINARY, side::LOCAL, true);
+    request(option::SGA, side::REMOTE, true);
+    request(option::BINARY, side::REMOTE, true);
+    request(option::NAWS, side::REMOTE, true);
+}
+
+void TelnetNegotiator::reset() {
+    for (size_t i = 0; i < OPTION_COUNT; i++) {
+        local[i] = {};
+        remote[i] = {};
+    }
+    sbLen = 0;
+    width = 0;
+    height = 0;
+}
+
+void TelnetNegotiator::request(const option opt, const side s, const bool enable) {
+    const auto optionCode = static_cast<uint8_t>(opt);
+    const auto idx = indexOf(optionCode);
+    if (idx == OPTION_COUNT || (enable && !isAccepted(optionCode, s))) return;
+
+    auto &st = stateOf(idx, s);
+    switch (st.state) {
+        case qState::NO:
+            if (enable) {
+                st.state = qState::WANTYES;
+                send(askCommand(s, true), optionCode);
+            }
+            break;
+
+        case qState::YES:
+            if (!enable) {
+                st.state = qState::WANTNO;
+                send(askCommand(s, false), optionCode);
+            }
+            break;
+
+        case qState::WANTNO:
+            // Answer pending, ask again afterwards if the request changed
+            st.opposite = enable;
+            break;
+
+        case qState::WANTYES:
+            st.opposite = !enable;
+            break;
+    }
+}
+
+void TelnetNegotiator::receive(const uint8_t cmd, const uint8_t optionCode) {
+    const auto s = cmd == WILL || cmd == WONT ? side::REMOTE : side::LOCAL;
+    const bool positive = cmd == WILL || cmd == DO;
+
+    const auto idx = indexOf(optionCode);
+    if (idx == OPTION_COUNT) {
+        // Unsupported options are always disabled
+        if (positive) send(askCommand(s, false), optionCode);
+        return;
+    }
+
+    auto &st = stateOf(idx, s);
+    if (positive) {
+        switch (st.state) {
+            case qState::NO:
+                if (isAccepted(optionCode, s)) {
+                    st.state = qState::YES;
+                    send(askCommand(s, true), optionCode);
+                } else {
+                    send(askCommand(s, false), optionCode);
+                }
+                break;
+
+            case qState::YES:
+                break;
+
+            case qState::WANTNO:
+                // Refused our disable request, or agreed to a queued enable request
+                st.state = st.opposite ? qState::YES : qState::NO;
+                st.opposite = false;
+                break;
+
+            case qState::WANTYES:
+                if (st.opposite) {
+                    st.state = qState::WANTNO;
+                    st.opposite = false;
+                    send(askCommand(s, false), optionCode);
+                } else {
+                    st.state = qState::YES;
+                }
+                break;
+        }
+    } else {
+        switch (st.state) {
+            case qState::NO:
+                break;
+
+            case qState::YES:
+                st.state = qState::NO;
+                send(askCommand(s, false), optionCode);
+                break;
+
+            case qState::WANTNO:
+                if (st.opposite) {
+                    st.state = qState::WANTYES;
+                    st.opposite = false;
+                    send(askCommand(s, true), optionCode);
+                } else {
+                    st.state = qState::NO;
+                }
+                break;
+
+            case qState::WANTYES:
+                st.state = qState::NO;
+                st.opposite = false;
+                break;
+        }
+    }
+}
+
+bool TelnetNegotiator::endSubnegotiation() {
+    // IAC SB NAWS WIDTH[1] WIDTH[0] HEIGHT[1] HEIGHT[0] IAC SE
+    if (sbLen != 5 || sbBuf[0] != static_cast<uint8_t>(option::NAWS)) return false;
+
+    const auto w = static_cast<uint16_t>(sbBuf[1] << 8 | sbBuf[2]);
+    const auto h = static_cast<uint16_t>(sbBuf[3] << 8 | sbBuf[4]);
+    if (w == width && h == height) return false;
+    width = w;
+    height = h;
+    return true;
+}
+
+bool TelnetNegotiator::isEnabled(const option opt, const side s) const {
+    const auto idx = indexOf(static_cast<uint8_t>(opt));
+    if (idx == OPTION_COUNT) return false;
+    return (s == side::LOCAL ? local[idx] : remote[idx]).state == qState::YES;
+}
+
+size_t TelnetNegotiator::indexOf(const uint8_t optionCode) {
+    for (size_t i = 0; i < OPTION_COUNT; i++) {
+        if (static_cast<uint8_t>(supportedOptions[i]) == optionCode) return i;
+    }
+    return OPTION_COUNT;
+}
+
+bool TelnetNegotiator::isAccepted(const uint8_t optionCode, const side s) {
+    switch (static_cast<option>(optionCode)) {
+        case option::BINARY:
+        case option::SGA:
+            return true;
+        case option::ECHO:
+            // The line editor echoes, a client side echo would double it
+            return s == side::LOCAL;
+        case option::NAWS:
+            return s == side::REMOTE;
+    }
+    return false;
+}
+
+void TelnetNegotiator::send(const uint8_t cmd, const uint8_t optionCode) {
+    const uint8_t buf[] = {IAC, cmd, optionCode};
+    onSendFn(buf, sizeof buf);
+}
+
+uint8_t TelnetNegotiator::askCommand(const side s, const bool enable) {
+    if (s == side::LOCAL) return enable ? WILL : WONT;
+    return enable ? DO : DONT;
+}
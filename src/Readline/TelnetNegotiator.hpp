@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_TELNETNEGOTIATOR_HPP
+#define LIBSMART_STM32SHELL_READLINE_TELNETNEGOTIATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/** Maximum number of bytes of a telnet subnegotiation, longer ones are ignored */
+#ifndef LIBSMART_STM32SHELL_TELNET_SB_LEN
+#define LIBSMART_STM32SHELL_TELNET_SB_LEN 8
+#endif
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Telnet option negotiation (RFC 854, RFC 1143).
+     *
+     * Keeps the state of every supported option for both sides of the connection
+     * and answers WILL/WONT/DO/DONT of the client. The Q method of RFC 1143 makes
+     * sure that a negotiation never loops, even if both sides ask at the same time.
+     *
+     * Supported are ECHO, SUPPRESS-GO-AHEAD and BINARY on the server side, and
+     * SUPPRESS-GO-AHEAD, BINARY and NAWS on the client side. Everything else is
+     * refused. With ECHO and SUPPRESS-GO-AHEAD enabled, the client sends every
+     * key stroke as it is typed and leaves the echo to the line editor.
+     */
+    class TelnetNegotiator {
+    public:
+        static constexpr uint8_t IAC = 0xff;
+        static constexpr uint8_t DONT = 0xfe;
+        static constexpr uint8_t DO = 0xfd;
+        static constexpr uint8_t WONT = 0xfc;
+        static constexpr uint8_t WILL = 0xfb;
+        static constexpr uint8_t SB = 0xfa;
+        static constexpr uint8_t SE = 0xf0;
+
+        using u_option = enum class option : uint8_t {
+            BINARY = 0,     ///< Binary transmission, RFC 856
+            ECHO = 1,       ///< Echo, RFC 857
+            SGA = 3,        ///< Suppress go ahead, RFC 858
+            NAWS = 31       ///< Negotiate about window size, RFC 1073
+        };
+
+        using u_side = enum class side : uint8_t {
+            LOCAL,      ///< Option performed by the server, WILL/WONT
+            REMOTE      ///< Option performed by the client, DO/DONT
+        };
+
+        using sendFn_t = std::function<void(const uint8_t *, size_t)>;
+
+        /**
+         * @brief Sets the function that sends negotiation commands to the client.
+         */
+        void registerOnSendFunction(const sendFn_t &fn) { this->onSendFn = fn; }
+
+        /**
+         * @brief Offers the options for character at a time mode.
+         *
+         * Asks to enable ECHO, SUPPRESS-GO-AHEAD and BINARY on the server side,
+         * and SUPPRESS-GO-AHEAD, BINARY and NAWS on the client side.
+         */
+        void begin();
+
+        /** @brief Forgets all negotiated options. */
+        void reset();
+
+        /**
+         * @brief Asks to enable or disable an option.
+         *
+         * @param opt    The option.
+         * @param s      Side that performs the option.
+         * @param enable true to enable, false to disable.
+         */
+        void request(option opt, side s, bool enable);
+
+        /**
+         * @brief Handles a WILL, WONT, DO or DONT received from the client.
+         *
+         * @param cmd    WILL, WONT, DO or DONT.
+         * @param optionCode The option byte.
+         */
+        void receive(uint8_t cmd, uint8_t optionCode);
+
+        /** @brief Starts collecting a subnegotiation. */
+        void beginSubnegotiation() { sbLen = 0; }
+
+        /** @brief Collects one byte of a subnegotiation, IAC IAC already unescaped. */
+        void subnegotiationByte(uint8_t ch) {
+            if (sbLen < sizeof sbBuf) sbBuf[sbLen] = ch;
+            if (sbLen <= sizeof sbBuf) sbLen++;
+        }
+
+        /**
+         * @brief Handles a complete subnegotiation.
+         *
+         * @return true if the client reported a new window size.
+         */
+        bool endSubnegotiation();
+
+        /** @return true if the option is enabled on that side. */
+        bool isEnabled(option opt, side s) const;
+
+        /** @return Terminal width in columns, 0 if the client did not report it. */
+        uint16_t getWidth() const { return width; }
+
+        /** @return Terminal height in rows, 0 if the client did not report it. */
+        uint16_t getHeight() const { return height; }
+
+    private:
+        /** Q method states of one side of an option. */
+        using u_qState = enum class qState : uint8_t {
+            NO, YES, WANTNO, WANTYES
+        };
+
+        struct optionState_t {
+            qState state;
+            /** true: the opposite request is queued behind the pending one. */
+            bool opposite;
+        };
+
+        /** Number of supported options. */
+        static constexpr size_t OPTION_COUNT = 4;
+
+        /** @return Index of a supported option, OPTION_COUNT otherwise. */
+        static size_t indexOf(uint8_t optionCode);
+
+        /** @return true if the option may be enabled on that side. */
+        static bool isAccepted(uint8_t optionCode, side s);
+
+        optionState_t &stateOf(size_t idx, side s) {
+            return s == side::LOCAL ? local[idx] : remote[idx];
+        }
+
+        void send(uint8_t cmd, uint8_t optionCode);
+
+        /** Command that asks the side to enable or disable an option. */
+        static uint8_t askCommand(side s, bool enable);
+
+        optionState_t local[OPTION_COUNT] = {};
+        optionState_t remote[OPTION_COUNT] = {};
+
+        uint8_t sbBuf[LIBSMART_STM32SHELL_TELNET_SB_LEN] = {};
+        /** Bytes of the current subnegotiation, sizeof sbBuf + 1 if it was too long. */
+        size_t sbLen = 0;
+
+        uint16_t width = 0;
+        uint16_t height = 0;
+
+        sendFn_t onSendFn = [](const uint8_t *, size_t) {
+        };
+    };
+}
+
+#endif
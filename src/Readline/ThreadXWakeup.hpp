@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_THREADXWAKEUP_HPP
+#define LIBSMART_STM32SHELL_READLINE_THREADXWAKEUP_HPP
+
+#include <tx_api.h>
+#include "WakeupInterface.hpp"
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Wakeup based on a ThreadX event flags group.
+     *
+     * tx_event_flags_set() is allowed in interrupt context, so a UART or DMA
+     * callback can wake the shell thread directly. begin() must be called
+     * once the kernel is running, before the first notify().
+     */
+    class ThreadXWakeup : public WakeupInterface {
+    public:
+        /** @return true if the event flags group has been created. */
+        bool begin() {
+            return tx_event_flags_create(&flags, const_cast<CHAR *>("Stm32Shell")) == TX_SUCCESS;
+        }
+
+        void notify() override {
+            tx_event_flags_set(&flags, FLAG, TX_OR);
+        }
+
+        bool wait(const uint32_t timeoutUs) override {
+            ULONG actual = 0;
+            // Rounded up, so a short timeout still blocks for one tick
+            const auto ticks = static_cast<ULONG>(
+                (static_cast<uint64_t>(timeoutUs) * TX_TIMER_TICKS_PER_SECOND + 999999U) / 1000000U);
+            return tx_event_flags_get(&flags, FLAG, TX_OR_CLEAR, &actual, ticks) == TX_SUCCESS;
+        }
+
+    private:
+        static constexpr ULONG FLAG = 0x1;
+        TX_EVENT_FLAGS_GROUP flags{};
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_READLINE_WAKEUPINTERFACE_HPP
+#define LIBSMART_STM32SHELL_READLINE_WAKEUPINTERFACE_HPP
+
+#include <cstdint>
+
+namespace Stm32Shell::Readline {
+    /**
+     * @brief Blocks the thread serving the sessions until there is work.
+     *
+     * A notification sent while nobody waits is kept, so the next wait()
+     * returns at once and no event is lost.
+     */
+    class WakeupInterface {
+    public:
+        virtual ~WakeupInterface() = default;
+
+        /** @brief Wakes the waiting thread. Can be called from interrupt context. */
+        virtual void notify() = 0;
+
+        /**
+         * @brief Waits for notify().
+         *
+         * @param timeoutUs Maximum time to wait [us].
+         * @return true if notified, false on timeout.
+         */
+        virtual bool wait(uint32_t timeoutUs) = 0;
+    };
+}
+
+#endif
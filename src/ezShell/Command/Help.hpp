@@ -6,11 +6,11 @@
 #ifndef LIBSMART_STM32SHELL_EZSHELL_COMMANDS_HELP_HPP
 #define LIBSMART_STM32SHELL_EZSHELL_COMMANDS_HELP_HPP
 
-#include "Command/AbstractCommand.hpp"
+#include "Command/PooledCommand.hpp"
 #include "ezShell/Shell.hpp"
 
 namespace Stm32Shell::ezShell::Command {
-    class Help : public Stm32Shell::Command::AbstractCommand {
+    class Help : public Stm32Shell::Command::PooledCommand<Help> {
     public:
         Help() {
             Nameable::setName("help");
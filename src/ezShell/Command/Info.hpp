@@ -8,81 +8,114 @@
 
 #include "globals.hpp"
 #include "Stm32NetX.hpp"
-#include "Command/AbstractCommand.hpp"
+#include "Command/PooledCommand.hpp"
 #include "ezShell/Shell.hpp"
 
-#define OUTPUT_PAUSE do{out()->flush();delay(20);}while(false);
-
 namespace Stm32Shell::ezShell::Command {
-    class Info : public Stm32Shell::Command::AbstractCommand {
+    class Info : public Stm32Shell::Command::PooledCommand<Info> {
     public:
         Info() {
             Nameable::setName("info");
-            isSync = true;
+            isSync = false;
             setLogger(&Logger);
         }
 
+        initReturn init() override {
+            line = 0;
+            return AbstractCommand::init();
+        }
+
         runReturn run() override {
-            auto ret = AbstractCommand::run();
-
-            out()->print(F("FIRMWARE: "));
-            out()->print(FIRMWARE_NAME);
-            out()->print(F(" v"));
-            out()->print(FIRMWARE_VERSION);
-            out()->print(F(" "));
-            out()->println(FIRMWARE_COPY);
-            OUTPUT_PAUSE;
-
-            out()->print(F("FIRMWARE_NAME: "));
-            out()->println(FIRMWARE_NAME);
-            OUTPUT_PAUSE;
-
-            out()->print(F("FIRMWARE_VERSION: "));
-            out()->println(FIRMWARE_VERSION);
-            OUTPUT_PAUSE;
-
-            out()->print(F("FIRMWARE_BUILDTIME: "));
-            out()->println(FIRMWARE_BUILDTIME);
-            OUTPUT_PAUSE;
-
-            out()->printf("HARDWARE_MAC: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
-                          static_cast<unsigned int>(heth.Init.MACAddr[0]),
-                          static_cast<unsigned int>(heth.Init.MACAddr[1]),
-                          static_cast<unsigned int>(heth.Init.MACAddr[2]),
-                          static_cast<unsigned int>(heth.Init.MACAddr[3]),
-                          static_cast<unsigned int>(heth.Init.MACAddr[4]),
-                          static_cast<unsigned int>(heth.Init.MACAddr[5]));
-            OUTPUT_PAUSE;
+            while (line < LINE_COUNT) {
+                // Yield until the transport has room for the next line
+                if (!hasOutputSpace(LINE_MAX)) return runReturn::RUNNING;
+                printLine(line++);
+            }
+            return AbstractCommand::run();
+        }
 
+    private:
+        /** Number of lines in the report. */
+        static constexpr uint8_t LINE_COUNT = 8;
+        /** Maximum length of a single line. */
+        static constexpr size_t LINE_MAX = 80;
+
+        /** Next line to print. */
+        uint8_t line = 0;
+
+        void printLine(const uint8_t lineNo) {
             ULONG ip_address, network_mask;
-            Stm32NetX::NX->getIpInstance()->ipAddressGet(&ip_address, &network_mask);
-            out()->printf("IP_ADDRESS: %lu.%lu.%lu.%lu\r\n",
-                          (ip_address >> 24) & 0xff,
-                          (ip_address >> 16) & 0xff,
-                          (ip_address >> 8) & 0xff,
-                          (ip_address >> 0) & 0xff
-            );
-            OUTPUT_PAUSE;
-
-            out()->printf("NETWORK_MASK: %lu.%lu.%lu.%lu\r\n",
-                          (network_mask >> 24) & 0xff,
-                          (network_mask >> 16) & 0xff,
-                          (network_mask >> 8) & 0xff,
-                          (network_mask >> 0) & 0xff
-            );
-            OUTPUT_PAUSE;
-
-            const auto gateway_address = Stm32NetX::NX->getIpInstance()->ipGatewayAddressGet();
-            out()->printf("GATEWAY_ADDRESS: %lu.%lu.%lu.%lu\r\n",
-                          (gateway_address >> 24) & 0xff,
-                          (gateway_address >> 16) & 0xff,
-                          (gateway_address >> 8) & 0xff,
-                          (gateway_address >> 0) & 0xff
-            );
-            out()->println();
-            OUTPUT_PAUSE;
-
-            return ret;
+
+            switch (lineNo) {
+                case 0:
+                    out()->print(F("FIRMWARE: "));
+                    out()->print(FIRMWARE_NAME);
+                    out()->print(F(" v"));
+                    out()->print(FIRMWARE_VERSION);
+                    out()->print(F(" "));
+                    out()->println(FIRMWARE_COPY);
+                    break;
+
+                case 1:
+                    out()->print(F("FIRMWARE_NAME: "));
+                    out()->println(FIRMWARE_NAME);
+                    break;
+
+                case 2:
+                    out()->print(F("FIRMWARE_VERSION: "));
+                    out()->println(FIRMWARE_VERSION);
+                    break;
+
+                case 3:
+                    out()->print(F("FIRMWARE_BUILDTIME: "));
+                    out()->println(FIRMWARE_BUILDTIME);
+                    break;
+
+                case 4:
+                    out()->printf("HARDWARE_MAC: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
+                                  static_cast<unsigned int>(heth.Init.MACAddr[0]),
+                                  static_cast<unsigned int>(heth.Init.MACAddr[1]),
+                                  static_cast<unsigned int>(heth.Init.MACAddr[2]),
+                                  static_cast<unsigned int>(heth.Init.MACAddr[3]),
+                                  static_cast<unsigned int>(heth.Init.MACAddr[4]),
+                                  static_cast<unsigned int>(heth.Init.MACAddr[5]));
+                    break;
+
+                case 5:
+                    Stm32NetX::NX->getIpInstance()->ipAddressGet(&ip_address, &network_mask);
+                    out()->printf("IP_ADDRESS: %lu.%lu.%lu.%lu\r\n",
+                                  (ip_address >> 24) & 0xff,
+                                  (ip_address >> 16) & 0xff,
+                                  (ip_address >> 8) & 0xff,
+                                  (ip_address >> 0) & 0xff
+                    );
+                    break;
+
+                case 6:
+                    Stm32NetX::NX->getIpInstance()->ipAddressGet(&ip_address, &network_mask);
+                    out()->printf("NETWORK_MASK: %lu.%lu.%lu.%lu\r\n",
+                                  (network_mask >> 24) & 0xff,
+                                  (network_mask >> 16) & 0xff,
+                                  (network_mask >> 8) & 0xff,
+                                  (network_mask >> 0) & 0xff
+                    );
+                    break;
+
+                case 7: {
+                    const auto gateway_address = Stm32NetX::NX->getIpInstance()->ipGatewayAddressGet();
+                    out()->printf("GATEWAY_ADDRESS: %lu.%lu.%lu.%lu\r\n",
+                                  (gateway_address >> 24) & 0xff,
+                                  (gateway_address >> 16) & 0xff,
+                                  (gateway_address >> 8) & 0xff,
+                                  (gateway_address >> 0) & 0xff
+                    );
+                    out()->println();
+                    break;
+                }
+
+                default:
+                    break;
+            }
         }
     };
 }
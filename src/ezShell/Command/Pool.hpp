@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_COMMANDS_POOL_HPP
+#define LIBSMART_STM32SHELL_EZSHELL_COMMANDS_POOL_HPP
+
+#include "Command/AbstractCommand.hpp"
+#include "Command/CommandPool.hpp"
+#include "ezShell/Shell.hpp"
+
+namespace Stm32Shell::ezShell::Command {
+    /**
+     * @brief Prints the usage counters of all command pools.
+     *
+     * One line per pool: POOL: <name> capacity=<n> used=<n> highwater=<n> failures=<n>
+     */
+    class Pool : public Stm32Shell::Command::AbstractCommand {
+    public:
+        Pool() {
+            Nameable::setName("pool");
+            isSync = true;
+            setLogger(&Stm32ItmLogger::logger);
+        }
+
+        runReturn run() override {
+            auto ret = AbstractCommand::run();
+            for (auto *pool = Stm32Shell::Command::CommandPoolInterface::first();
+                 pool != nullptr; pool = pool->getNext()) {
+                out()->printf("POOL: %s capacity=%lu used=%lu highwater=%lu failures=%lu\r\n",
+                              pool->getName(),
+                              static_cast<unsigned long>(pool->getCapacity()),
+                              static_cast<unsigned long>(pool->getUsed()),
+                              static_cast<unsigned long>(pool->getHighWater()),
+                              static_cast<unsigned long>(pool->getFailures()));
+            }
+            return ret;
+        }
+    };
+}
+#endif
@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_COMMANDS_STATS_HPP
+#define LIBSMART_STM32SHELL_EZSHELL_COMMANDS_STATS_HPP
+
+#include <cstring>
+#include "Command/PooledCommand.hpp"
+#include "Command/CommandMetrics.hpp"
+#include "ezShell/Shell.hpp"
+
+namespace Stm32Shell::ezShell::Command {
+    /**
+     * @brief Prints the metrics of all commands, or resets them with "stats reset".
+     *
+     * One line with the bucket limits, then per command one counter line and one
+     * line per phase, all key=value pairs separated by spaces. Times are in us,
+     * hist lists the bucket counts in the order of the limits:
+     *
+     * STATS: buckets=4,16,...
+     * STATS: <name> invocations=<n> errors=<n> timeouts=<n> terminations=<n>
+     * STATS: <name> phase=<phase> count=<n> min=<us> max=<us> mean=<us> hist=<n>,<n>,...
+     */
+    class Stats : public Stm32Shell::Command::PooledCommand<Stats> {
+        using CommandMetrics = Stm32Shell::Command::CommandMetrics;
+
+    public:
+        Stats() {
+            Nameable::setName("stats");
+            isSync = false;
+            setLogger(&Stm32ItmLogger::logger);
+            setArgSpecs(argSpecs);
+        }
+
+        initReturn init() override {
+            cmdIndex = 0;
+            line = 0;
+            if (args.getEnum('a') == ACTION_RESET) {
+                auto &registry = Shell::getCommandRegistry();
+                for (size_t i = 0; i < registry.size(); i++) registry.metricsAt(i)->reset();
+                cmdIndex = registry.size();
+                line = 1;
+            }
+            return AbstractCommand::init();
+        }
+
+        runReturn run() override {
+            auto &registry = Shell::getCommandRegistry();
+            if (cmdIndex == 0 && line == 0) {
+                if (!hasOutputSpace(BUCKETS_LINE_MAX)) return runReturn::RUNNING;
+                printBuckets();
+                line = 1;
+            }
+            while (cmdIndex < registry.size()) {
+                // Yield until the transport has room for the next line
+                const auto *name = registry.at(cmdIndex)->getName();
+                if (!hasOutputSpace(LINE_MAX + strlen(name))) return runReturn::RUNNING;
+                printLine(name, *registry.metricsAt(cmdIndex), line);
+                if (++line > CommandMetrics::PHASE_COUNT + 1) {
+                    line = 1;
+                    cmdIndex++;
+                }
+            }
+            return AbstractCommand::run();
+        }
+
+        vocabulary_t getVocabulary(int argIndex) override {
+            if (argIndex != 1) return {};
+            return {actions, std::size(actions)};
+        }
+
+    private:
+        static constexpr int ACTION_RESET = 0;
+        inline static const char *const actions[] = {"reset"};
+        inline static const Stm32Shell::Command::Arguments::spec_t argSpecs[] = {
+            {'a', Stm32Shell::Command::Arguments::type::ENUM, true, false, actions, std::size(actions)},
+        };
+
+        /** Maximum number of digits of a 32 bit value. */
+        static constexpr size_t NUMBER_MAX = 10;
+
+        /** Maximum length of a list of bucket limits or counts. */
+        static constexpr size_t LIST_MAX = CommandMetrics::BUCKET_COUNT * (NUMBER_MAX + 1) - 1;
+
+        /** Maximum length of the line with the bucket limits, including CR LF. */
+        static constexpr size_t BUCKETS_LINE_MAX = sizeof "STATS: buckets=\r\n" - 1 + LIST_MAX;
+
+        /**
+         * Maximum length of a command line without the name, including CR LF.
+         * The phase lines are the longest, the counter line has 4 numbers and no list.
+         */
+        static constexpr size_t LINE_MAX = sizeof "STATS:  phase=preflightcheck count= min= max= mean= hist=\r\n" - 1
+                                           + 4 * NUMBER_MAX + LIST_MAX;
+
+        static_assert(sizeof "STATS:  invocations= errors= timeouts= terminations=\r\n" - 1 + 4 * NUMBER_MAX
+                      <= LINE_MAX, "The counter line must not be longer than a phase line");
+
+        /** Command to print next. */
+        size_t cmdIndex = 0;
+        /** Line of the command to print next, 1 is the counter line. */
+        size_t line = 0;
+
+        void printBuckets() {
+            out()->print("STATS: buckets=");
+            for (size_t b = 0; b < CommandMetrics::BUCKET_COUNT; b++) {
+                out()->printf(b == 0 ? "%lu" : ",%lu", static_cast<unsigned long>(CommandMetrics::bucketLimit(b)));
+            }
+            out()->println();
+        }
+
+        void printLine(const char *name, const CommandMetrics &metrics, const size_t lineNo) {
+            if (lineNo == 1) {
+                out()->printf("STATS: %s invocations=%lu errors=%lu timeouts=%lu terminations=%lu\r\n",
+                              name,
+                              static_cast<unsigned long>(metrics.getInvocations()),
+                              static_cast<unsigned long>(metrics.getErrors()),
+                              static_cast<unsigned long>(metrics.getTimeouts()),
+                              static_cast<unsigned long>(metrics.getTerminations()));
+                return;
+            }
+
+            const auto p = static_cast<CommandMetrics::phase>(lineNo - 2);
+            const auto &histogram = metrics.getHistogram(p);
+            const auto count = histogram.count();
+            out()->printf("STATS: %s phase=%s count=%lu min=%lu max=%lu mean=%lu hist=",
+                          name,
+                          CommandMetrics::phaseName(p),
+                          static_cast<unsigned long>(count),
+                          static_cast<unsigned long>(count == 0 ? 0 : histogram.min),
+                          static_cast<unsigned long>(histogram.max),
+                          static_cast<unsigned long>(histogram.mean()));
+            for (size_t b = 0; b < CommandMetrics::BUCKET_COUNT; b++) {
+                out()->printf(b == 0 ? "%lu" : ",%lu", static_cast<unsigned long>(histogram.buckets[b]));
+            }
+            out()->println();
+        }
+    };
+}
+#endif
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CommandRegistry.hpp"
+#include <cstring>
+
+using namespace Stm32Shell::ezShell;
+using namespace Stm32Shell::Command;
+
+namespace {
+    /** Binary search for the first command for which less() is false. */
+    template<typename Less>
+    size_t lowerBoundBy(CommandInterface *const *commands, const size_t count, Less less) {
+        size_t lo = 0;
+        size_t hi = count;
+        while (lo < hi) {
+            const auto mid = lo + (hi - lo) / 2;
+            if (less(commands[mid]->getName())) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+}
+
+CommandRegistry::addReturn CommandRegistry::add(CommandInterface *cmd) {
+    if (cmd == nullptr || cmd->getName() == nullptr) return addReturn::INVALID;
+    if (count >= commands.size()) return addReturn::FULL;
+
+    const auto name = cmd->getName();
+    const auto pos = lowerBound(name);
+    if (pos < count && std::strcmp(commands[pos]->getName(), name) == 0) return addReturn::DUPLICATE;
+
+    for (size_t i = count; i > pos; i--) {
+        commands[i] = commands[i - 1];
+        metrics[i] = metrics[i - 1];
+    }
+    commands[pos] = cmd;
+    metrics[pos].reset();
+    count++;
+    return addReturn::OK;
+}
+
+CommandInterface *CommandRegistry::find(const char *name) const {
+    return at(indexOf(name));
+}
+
+size_t CommandRegistry::indexOf(const char *name) const {
+    if (name == nullptr) return count;
+    const auto pos = lowerBound(name);
+    if (pos < count && std::strcmp(commands[pos]->getName(), name) == 0) return pos;
+    return count;
+}
+
+size_t CommandRegistry::lowerBound(const char *name) const {
+    return lowerBoundBy(commands.data(), count, [name](const char *cmdName) {
+        return std::strcmp(cmdName, name) < 0;
+    });
+}
+
+size_t CommandRegistry::lowerBoundPrefix(const char *prefix, const size_t len) const {
+    return lowerBoundBy(commands.data(), count, [prefix, len](const char *cmdName) {
+        return std::strncmp(cmdName, prefix, len) < 0;
+    });
+}
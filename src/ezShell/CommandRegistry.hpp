@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_COMMANDREGISTRY_HPP
+#define LIBSMART_STM32SHELL_EZSHELL_COMMANDREGISTRY_HPP
+
+#include <array>
+#include <cstddef>
+#include "Command/CommandInterface.hpp"
+#include "Command/CommandMetrics.hpp"
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_MAX_CMD
+#define LIBSMART_STM32SHELL_EZSHELL_MAX_CMD 20
+#endif
+
+namespace Stm32Shell::ezShell {
+    /**
+     * @brief Registry of all commands known to the shell.
+     *
+     * The commands are kept sorted by name, so a lookup is a binary search
+     * with O(log n) string compares instead of a linear scan over all slots.
+     * Registering is O(n), but happens only once at startup.
+     *
+     * Every command has its metrics next to it, shared by all sessions.
+     */
+    class CommandRegistry {
+    public:
+        using u_addReturn = enum class addReturn {
+            OK, FULL, DUPLICATE, INVALID
+        };
+
+        /**
+         * @brief Adds a command to the registry.
+         *
+         * @param cmd The command to add. Its name must not change afterwards.
+         * @return OK on success, FULL if no slot is left, DUPLICATE if a command
+         *         with the same name is already registered, INVALID for nullptr.
+         */
+        addReturn add(Command::CommandInterface *cmd);
+
+        /**
+         * @brief Finds a command by its name.
+         *
+         * @param name The command name to look for.
+         * @return The command or nullptr, if no command with this name is registered.
+         */
+        Command::CommandInterface *find(const char *name) const;
+
+        /**
+         * @brief Finds the index of a command by its name.
+         *
+         * @param name The command name to look for.
+         * @return Index of the command, or size() if no command with this name is registered.
+         */
+        size_t indexOf(const char *name) const;
+
+        /**
+         * @brief Returns the index of the first command whose name does not sort before a prefix.
+         *
+         * The commands starting with the prefix follow from this index on.
+         *
+         * @param prefix Prefix to search for.
+         * @param len    Number of characters of prefix to compare.
+         * @return Index in [0, size()].
+         */
+        size_t lowerBoundPrefix(const char *prefix, size_t len) const;
+
+        /** @return Number of registered commands. */
+        size_t size() const { return count; }
+
+        /** @return Maximum number of commands. */
+        static constexpr size_t capacity() { return LIBSMART_STM32SHELL_EZSHELL_MAX_CMD; }
+
+        /** @return The command at index i in name order. */
+        Command::CommandInterface *at(size_t i) const { return i < count ? commands[i] : nullptr; }
+
+        /** @return The metrics of the command at index i, nullptr if i is out of range. */
+        Command::CommandMetrics *metricsAt(size_t i) { return i < count ? &metrics[i] : nullptr; }
+
+        Command::CommandInterface *const *begin() const { return commands.data(); }
+        Command::CommandInterface *const *end() const { return commands.data() + count; }
+
+    private:
+        /** @return Index of the first command whose name is not less than name, in [0, size()]. */
+        size_t lowerBound(const char *name) const;
+
+        std::array<Command::CommandInterface *, LIBSMART_STM32SHELL_EZSHELL_MAX_CMD> commands = {};
+        std::array<Command::CommandMetrics, LIBSMART_STM32SHELL_EZSHELL_MAX_CMD> metrics = {};
+        size_t count = 0;
+    };
+}
+#endif
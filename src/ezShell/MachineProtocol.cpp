@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "MachineProtocol.hpp"
+#include <array>
+#include <cstring>
+
+using namespace Stm32Shell::ezShell;
+
+namespace {
+    constexpr std::array<uint16_t, 256> makeCrcTable() {
+        std::array<uint16_t, 256> table{};
+        for (size_t i = 0; i < table.size(); i++) {
+            auto crc = static_cast<uint16_t>(i << 8);
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    /** CRC-16/CCITT-FALSE lookup table, polynomial 0x1021. */
+    constexpr auto crcTable = makeCrcTable();
+}
+
+uint16_t MachineProtocol::crc16(const uint8_t *data, const size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ crcTable[((crc >> 8) ^ data[i]) & 0xff]);
+    }
+    return crc;
+}
+
+size_t MachineProtocol::frame(uint8_t *buf, const uint8_t seq, const uint8_t code, const size_t payloadLen) {
+    const size_t len = payloadLen + 2;
+    buf[0] = SOF;
+    buf[1] = static_cast<uint8_t>(len & 0xff);
+    buf[2] = static_cast<uint8_t>(len >> 8);
+    buf[3] = seq;
+    buf[4] = code;
+    const auto crc = crc16(buf + 1, len + 2);
+    buf[HEADER_LEN + payloadLen] = static_cast<uint8_t>(crc & 0xff);
+    buf[HEADER_LEN + payloadLen + 1] = static_cast<uint8_t>(crc >> 8);
+    return payloadLen + OVERHEAD;
+}
+
+size_t MachineFrameParser::parse(const uint8_t *data, const size_t len, parseResult &result) {
+    result = parseResult::INCOMPLETE;
+    size_t used = 0;
+    while (used < len) {
+        switch (state) {
+            case parserState::SOF: {
+                const auto *sof = static_cast<const uint8_t *>(memchr(data + used, MachineProtocol::SOF, len - used));
+                if (sof == nullptr) return len;
+                used = static_cast<size_t>(sof - data) + 1;
+                pos = 0;
+                state = parserState::LENGTH;
+                break;
+            }
+
+            case parserState::LENGTH:
+                buf[pos++] = data[used++];
+                if (pos < 2) break;
+                frameLen = buf[0] | (buf[1] << 8);
+                if (frameLen < 2 || frameLen > LIBSMART_STM32SHELL_MACHINE_MAX_FRAME) {
+                    reset();
+                    result = parseResult::ERROR;
+                    return used;
+                }
+                state = parserState::BODY;
+                break;
+
+            case parserState::BODY: {
+                const size_t want = 2 + frameLen + MachineProtocol::CRC_LEN - pos;
+                const size_t n = want < len - used ? want : len - used;
+                memcpy(buf + pos, data + used, n);
+                pos += n;
+                used += n;
+                if (n < want) break;
+
+                const auto crc = static_cast<uint16_t>(buf[2 + frameLen] | (buf[3 + frameLen] << 8));
+                result = MachineProtocol::crc16(buf, 2 + frameLen) == crc ? parseResult::FRAME : parseResult::ERROR;
+                state = parserState::SOF;
+                pos = 0;
+                return used;
+            }
+        }
+    }
+    return used;
+}
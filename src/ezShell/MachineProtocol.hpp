@@ -0,0 +1,252 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_MACHINEPROTOCOL_HPP
+#define LIBSMART_STM32SHELL_EZSHELL_MACHINEPROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/** Maximum number of bytes between the length field and the CRC of a request frame */
+#ifndef LIBSMART_STM32SHELL_MACHINE_MAX_FRAME
+#define LIBSMART_STM32SHELL_MACHINE_MAX_FRAME 96
+#endif
+
+/** Time in ms after bytes outside of a valid frame until the session leaves machine mode */
+#ifndef LIBSMART_STM32SHELL_MACHINE_GARBAGE_TIMEOUT
+#define LIBSMART_STM32SHELL_MACHINE_GARBAGE_TIMEOUT 2000
+#endif
+
+namespace Stm32Shell::ezShell {
+    /**
+     * @brief Binary framed protocol for automation clients ("machine mode").
+     *
+     * A client switches a session to machine mode by sending START at an empty
+     * prompt. A request frame then runs one command, without echo, line editing
+     * or tokenizing:
+     *
+     *   SOF | LEN (2) | SEQ | CMD | ARG... | CRC (2)
+     *
+     * LEN counts the bytes from SEQ to the end of the arguments. CMD is the index
+     * of the command in the registry, or one of the reserved commands. The registry
+     * is sorted by name, so registering a command at runtime shifts the ids of all
+     * commands behind it, a client gets the current ids with CMD_LIST. Each ARG is
+     * a length byte followed by that many bytes of text, the command parses them
+     * with its argument specs. Multi byte fields are little endian, the CRC is
+     * CRC-16/CCITT-FALSE over LEN to the end of the arguments.
+     *
+     * Every request is answered with zero or more OUTPUT frames, carrying the output
+     * of the command, and one final frame with a status code. Response frames have the
+     * same layout, with the status in place of CMD and the data in place of ARG...
+     * SEQ is copied from the request, so a client can pipeline requests.
+     *
+     * Ctrl+C between frames terminates the active command like CMD_ABORT. Bytes
+     * outside of frames without a valid frame for LIBSMART_STM32SHELL_MACHINE_GARBAGE_TIMEOUT
+     * return the session to the line editor, e.g. after a human typed START by accident.
+     */
+    class MachineProtocol {
+    public:
+        /** Start of frame. */
+        static constexpr uint8_t SOF = 0xa5;
+        /**
+         * Switches to machine mode at an empty prompt. A single SOF is a printable
+         * character in Latin-1 and other code pages, the NUL bytes do not occur in
+         * typed or pasted text.
+         */
+        static constexpr uint8_t START[] = {SOF, 0x00, 0x5a, 0x00};
+        /** Ctrl+C, terminates the active command when received between frames. */
+        static constexpr uint8_t CTRL_C = 0x03;
+        /** Length of SOF, LEN, SEQ and CMD/status. */
+        static constexpr size_t HEADER_LEN = 5;
+        /** Length of the CRC. */
+        static constexpr size_t CRC_LEN = 2;
+        /** Bytes a frame adds to its payload. */
+        static constexpr size_t OVERHEAD = HEADER_LEN + CRC_LEN;
+
+        /** Reserved command: lists the commands as OUTPUT frames of id and name. */
+        static constexpr uint8_t CMD_LIST = 0xff;
+        /** Reserved command: leaves machine mode, ERR_BUSY while a command is active or queued. */
+        static constexpr uint8_t CMD_EXIT = 0xfe;
+        /** Reserved command: terminates the active command and drops queued ones, like Ctrl+C. */
+        static constexpr uint8_t CMD_ABORT = 0xfd;
+
+        using u_status = enum class status : uint8_t {
+            OK = 0x00,                  ///< Command finished
+            OUTPUT = 0x01,              ///< Output of the command, more frames follow
+            ERR_FRAME = 0x80,           ///< Frame too long or CRC error
+            ERR_UNKNOWN_COMMAND = 0x81, ///< No command with this id
+            ERR_BUSY = 0x82,            ///< Command is used by another session, or CMD_LIST/CMD_EXIT cannot run now
+            ERR_ARGUMENTS = 0x83,       ///< Invalid arguments, the payload is the error message
+            ERR_PREFLIGHTCHECK = 0x84,  ///< preFlightCheck() failed
+            ERR_INIT = 0x85,            ///< init() failed
+            ERR_RUN = 0x86,             ///< run() failed
+            ERR_TIMEOUT = 0x87,         ///< Run timeout expired
+            TERMINATED = 0x88,          ///< Terminated by CMD_ABORT
+            ERR_QUEUE_FULL = 0x89,      ///< Too many pipelined requests
+            ERR_OVERFLOW = 0x8a         ///< Response did not fit into the TX buffer
+        };
+
+        /**
+         * @brief Computes the CRC-16/CCITT-FALSE.
+         *
+         * @param data Data.
+         * @param len  Number of bytes.
+         * @param crc  Start value, or the result of a previous call to continue.
+         */
+        static uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xffff);
+
+        /**
+         * @brief Completes a frame around a payload.
+         *
+         * @param buf        Frame buffer, the payload must already be at buf + HEADER_LEN.
+         * @param seq        Sequence number.
+         * @param code       Command or status.
+         * @param payloadLen Length of the payload.
+         * @return Length of the frame, payloadLen + OVERHEAD.
+         */
+        static size_t frame(uint8_t *buf, uint8_t seq, uint8_t code, size_t payloadLen);
+    };
+
+
+    /**
+     * @brief Collects request frames from a byte stream.
+     *
+     * Bytes outside of frames are skipped, so a client can resynchronize after an
+     * error by sending the next frame.
+     */
+    class MachineFrameParser {
+    public:
+        using u_parseResult = enum class parseResult {
+            INCOMPLETE,     ///< All bytes consumed, no frame complete
+            FRAME,          ///< A valid frame is complete
+            ERROR           ///< A frame was too long or had a CRC error
+        };
+
+        /**
+         * @brief Consumes bytes up to the end of the next frame.
+         *
+         * @param data   Received bytes.
+         * @param len    Number of received bytes.
+         * @param result FRAME or ERROR if a frame ended, INCOMPLETE otherwise.
+         * @return Number of bytes consumed. Call again with the rest.
+         */
+        size_t parse(const uint8_t *data, size_t len, parseResult &result);
+
+        /** @brief Drops a partially received frame. */
+        void reset() {
+            state = parserState::SOF;
+            pos = 0;
+        }
+
+        /** @return true if no frame is partially received. */
+        bool isIdle() const { return state == parserState::SOF; }
+
+        uint8_t getSeq() const { return buf[2]; }
+        uint8_t getCommand() const { return buf[3]; }
+        const uint8_t *getPayload() const { return buf + 4; }
+        size_t getPayloadLength() const { return frameLen - 2; }
+
+    private:
+        using u_parserState = enum class parserState : uint8_t {
+            SOF, LENGTH, BODY
+        };
+
+        parserState state = parserState::SOF;
+        /** LEN, SEQ, CMD, arguments and CRC of the current frame. */
+        uint8_t buf[2 + LIBSMART_STM32SHELL_MACHINE_MAX_FRAME + MachineProtocol::CRC_LEN] = {};
+        size_t pos = 0;
+        /** Value of LEN of the current frame. */
+        size_t frameLen = 0;
+    };
+
+
+    /**
+     * @brief Writes response frames into a TX buffer, status frames wait while it is full.
+     *
+     * Status frames leave in the order they were given: while one is pending, later
+     * ones queue behind it even if they would fit. Call flush() when the transport
+     * has made room.
+     *
+     * The TX buffer is passed to every call, it needs getRemainingSpace(),
+     * getWritePointer() and setWrittenBytes().
+     *
+     * @tparam N Number of status frames that can be pending.
+     */
+    template<size_t N>
+    class MachineResponder {
+    public:
+        /**
+         * @brief Writes a frame into the TX buffer.
+         *
+         * @return false if the frame does not fit into the TX buffer.
+         */
+        template<typename Tx>
+        static bool send(Tx *tx, const uint8_t seq, const MachineProtocol::status status, const void *payload,
+                         const size_t len) {
+            if (tx->getRemainingSpace() < len + MachineProtocol::OVERHEAD) return false;
+            auto *frame = tx->getWritePointer();
+            if (len > 0) memcpy(frame + MachineProtocol::HEADER_LEN, payload, len);
+            tx->setWrittenBytes(MachineProtocol::frame(frame, seq, static_cast<uint8_t>(status), len));
+            return true;
+        }
+
+        /**
+         * @brief Writes a status frame, or keeps it pending until the TX buffer has room.
+         *
+         * @param message Payload, must be static text or nullptr.
+         * @return false if N frames are already pending and this one is dropped.
+         */
+        template<typename Tx>
+        bool respond(Tx *tx, const uint8_t seq, const MachineProtocol::status status, const char *message = nullptr) {
+            if (count == 0 && send(tx, seq, status, message, message == nullptr ? 0 : strlen(message))) return true;
+            if (count == N) return false;
+            pending[(head + count) % N] = {seq, status, message};
+            count++;
+            return true;
+        }
+
+        /**
+         * @brief Writes the pending status frames as far as the TX buffer takes them.
+         *
+         * @return true if no status frame is pending anymore.
+         */
+        template<typename Tx>
+        bool flush(Tx *tx) {
+            while (count > 0) {
+                const auto &entry = pending[head];
+                if (!send(tx, entry.seq, entry.status, entry.message,
+                          entry.message == nullptr ? 0 : strlen(entry.message))) {
+                    return false;
+                }
+                head = (head + 1) % N;
+                count--;
+            }
+            return true;
+        }
+
+        /** @brief Drops the pending status frames. */
+        void clear() { count = 0; }
+
+        /** @return Number of pending status frames. */
+        size_t getPending() const { return count; }
+
+    private:
+        /** A status frame waiting for space in the TX buffer. */
+        struct pending_t {
+            uint8_t seq;
+            MachineProtocol::status status;
+            /** Payload, static text or nullptr. */
+            const char *message;
+        };
+
+        /** Ring of count entries starting at head. */
+        pending_t pending[N] = {};
+        size_t head = 0;
+        size_t count = 0;
+    };
+}
+
+#endif
@@ -5,18 +5,59 @@
 
 #include "Shell.hpp"
 #include "Command/Help.hpp"
+#include "Log.hpp"
 
 using namespace Stm32Shell::ezShell;
 using namespace Stm32Shell::Command;
 
-std::array<CommandInterface *, LIBSMART_STM32SHELL_EZSHELL_MAX_CMD> Shell::cmdRegistry = {};
+CommandRegistry Shell::cmdRegistry;
+
+// Command ids share the CMD byte of a request frame with the reserved commands
+static_assert(LIBSMART_STM32SHELL_EZSHELL_MAX_CMD < MachineProtocol::CMD_ABORT,
+              "Too many commands for the machine mode command ids");
 
 void Shell::setup() {
     AbstractMicrorlStreamSession::setup();
+    setMachineModeStart(MachineProtocol::START, sizeof MachineProtocol::START);
     // registerCmd(&Command::help);
     setCwd("/");
 }
 
+void Shell::loop() {
+    // Keeps a cycle counter based clock in step, also while no command runs
+    CommandContext::getClock()->micros();
+    AbstractMicrorlStreamSession::loop();
+    if (sendPendingStatus()) stepList();
+    runCommand();
+
+    // Only garbage since START, e.g. typed by accident, return to the line editor
+    if (isMachineMode() && machineGarbage.hasExpired(CommandContext::getClock()->micros())
+        && !cmdCtx.hasCommand() && cmdQueueCount == 0) {
+        leaveMachineMode();
+    }
+}
+
+void Shell::end() {
+    AbstractMicrorlStreamSession::end();
+    // The responses belong to the client that has gone
+    cmdRunnable = false;
+    responder.clear();
+    listActive = false;
+    frameParser.reset();
+    machineGarbage.clear();
+}
+
+bool Shell::hasPendingWork() {
+    // Output waiting for the TX buffer is resumed by requestService() of the transport
+    return cmdRunnable || AbstractMicrorlStreamSession::hasPendingWork();
+}
+
+uint32_t Shell::getTimeToDeadline(const uint32_t now) {
+    auto timeout = cmdCtx.getTimeToDeadline(now);
+    if (isMachineMode() && machineGarbage.isArmed()) timeout = std::min(timeout, machineGarbage.remaining(now));
+    return timeout;
+}
+
 void Shell::setCwd(const char *cwd) {
     snprintf(prompt, sizeof(prompt), "[user@hostname] %s> ", cwd);
     cwd = prompt + 16;
@@ -24,80 +65,481 @@ void Shell::setCwd(const char *cwd) {
 }
 
 void Shell::registerCmd(CommandInterface *cmd) {
-    for (size_t i = 0; i < cmdRegistry.size(); i++) {
-        if (cmdRegistry[i] == nullptr) {
-            cmdRegistry[i] = cmd;
-            Stm32ItmLogger::logger.setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
-                    ->printf("Stm32Shell::ezShell::Shell::registerCmd %lu/%lu\r\n", registeredCommands(),
-                             cmdRegistry.size());
-            return;
-        }
+    if (cmdRegistry.add(cmd) != CommandRegistry::addReturn::OK) {
+        LIBSMART_STM32SHELL_LOG_GLOBAL(ERROR)
+                ->printf("Stm32Shell::ezShell::Shell::registerCmd failed %lu/%lu\r\n", registeredCommands(),
+                         CommandRegistry::capacity());
+        return;
     }
+    LIBSMART_STM32SHELL_LOG_GLOBAL(INFORMATIONAL)
+            ->printf("Stm32Shell::ezShell::Shell::registerCmd %lu/%lu\r\n", registeredCommands(),
+                     CommandRegistry::capacity());
 }
 
 size_t Shell::registeredCommands() {
-    auto count = cmdRegistry.size();
-    for (auto i = 0; i < cmdRegistry.size(); i++) {
-        if (cmdRegistry[i] != nullptr) count--;
-    }
-    return count;
+    return cmdRegistry.size();
+}
+
+CommandRegistry &Shell::getCommandRegistry() {
+    return cmdRegistry;
 }
 
 int Shell::executeCallback(int argc, const char *const *argv) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
             ->println("Stm32Shell::ezShell::Shell::executeCallback()");
 
-    log()->print("Tokens found: ");
-    for (int i = 0; i < argc; i++) {
-        log()->printf("{%s} ", argv[i]);
-    }
-    log()->println();
-
-
-    for (size_t i = 0; i < cmdRegistry.size(); i++) {
-        if (cmdRegistry[i] != nullptr) {
-            if (std::strcmp(cmdRegistry[i]->getName(), argv[0]) == 0) {
-                // Command found
-                log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
-                        ->printf("Command found: %s\r\n", cmdRegistry[i]->getName());
-
-                cmdCtx.setLogger(getLogger());
-                cmdCtx.setCommand(cmdRegistry[i]);
-
-                cmdRegistry[i]->setParam(argc, argv);
-
-                cmdCtx.registerOnWriteFunction([this]() {
-                    // Logger.println("onWriteFn()");
-                    if (this->cmdCtx.outputLength() > 0) {
-                        const auto result = this->cmdCtx.outputRead(
-                            reinterpret_cast<char *>(this->getTxBuffer()->getWritePointer()),
-                            this->getTxBuffer()->getRemainingSpace());
-                        this->getTxBuffer()->setWrittenBytes(result);
-                    }
-                });
-
-                cmdCtx.registerOnCmdEndFunction([this]() {
-                    // Debugger_log(DBG, "onCmdEndFn()");
-                });
-
-                cmdCtx.do_preFlightCheck();
-                cmdCtx.do_init();
-                if (cmdCtx.isCmdSync()) {
-                    cmdCtx.do_run();
-                    cmdCtx.do_cleanup();
-                    cmdCtx.recycle();
-                    return 0;
-                }
-
-                cmdCtx.recycle();
-                break;
+    if constexpr (LIBSMART_STM32SHELL_LOG_ENABLED(DEBUGGING)) {
+        LIBSMART_STM32SHELL_LOG(DEBUGGING)->print("Tokens found: ");
+        for (int i = 0; i < argc; i++) {
+            LIBSMART_STM32SHELL_LOG(DEBUGGING)->printf("{%s} ", argv[i]);
+        }
+        LIBSMART_STM32SHELL_LOG(DEBUGGING)->println();
+    }
+
+    dispatch(argc, argv, 0);
+    return 0;
+}
+
+void Shell::dispatch(const int argc, const char *const *argv, const uint8_t seq) {
+    if (cmdCtx.hasCommand() || cmdQueueCount > 0) {
+        // Pipelined command, started when the active command has been recycled
+        if (!queueCommand(argc, argv, seq)) {
+            respondError(seq, MachineProtocol::status::ERR_QUEUE_FULL,
+                         "ERROR: Command queue full, '%s' dropped\r\n", argc > 0 ? argv[0] : "");
+        }
+        startQueuedCommands();
+        return;
+    }
+
+    startCommand(copyArgs(argc, argv), seq);
+}
+
+void Shell::startCommand(const int argc, const uint8_t seq) {
+    const char *const *argv = argvBuffer;
+    cmdSeq = seq;
+
+    const auto cmdIndex = argc > 0 ? cmdRegistry.indexOf(argv[0]) : cmdRegistry.size();
+    auto *prototype = cmdRegistry.at(cmdIndex);
+    if (prototype != nullptr) {
+        // Command found, run a session local instance if the command provides one
+        auto *cmd = prototype->factory();
+        ownedCmd = cmd;
+        if (cmd == nullptr) cmd = prototype;
+
+        if (!cmdCtx.setCommand(cmd)) {
+            releaseCommand();
+            respondError(seq, MachineProtocol::status::ERR_BUSY,
+                         "ERROR: Command '%s' is busy in another session\r\n", argv[0]);
+            return;
+        }
+
+        LIBSMART_STM32SHELL_LOG(INFORMATIONAL)
+                ->printf("Command found: %s\r\n", cmd->getName());
+
+        cmdCtx.setLogger(getLogger());
+        cmdCtx.setMetrics(cmdRegistry.metricsAt(cmdIndex));
+        cmdCtx.setTextStatus(!isMachineMode());
+
+        cmd->setParam(argc, argvBuffer);
+
+        cmdCtx.registerOnWriteFunction([this]() {
+            // Logger.println("onWriteFn()");
+            if (this->cmdCtx.outputLength() == 0) return;
+            auto *tx = this->getTxBuffer();
+            if (!this->isMachineMode()) {
+                const auto result = this->cmdCtx.outputRead(
+                    reinterpret_cast<char *>(tx->getWritePointer()), this->getTxSpace());
+                tx->setWrittenBytes(this->escapeTx(result));
+                return;
             }
+
+            // Machine mode: the output goes out as OUTPUT frames
+            if (tx->getRemainingSpace() <= MachineProtocol::OVERHEAD) return;
+            auto *frame = tx->getWritePointer();
+            const auto result = this->cmdCtx.outputRead(
+                reinterpret_cast<char *>(frame + MachineProtocol::HEADER_LEN),
+                tx->getRemainingSpace() - MachineProtocol::OVERHEAD);
+            tx->setWrittenBytes(MachineProtocol::frame(
+                frame, this->cmdSeq, static_cast<uint8_t>(MachineProtocol::status::OUTPUT), result));
+        });
+
+        cmdCtx.registerOnReserveFunction([this]() {
+            auto *tx = this->getTxBuffer();
+            auto *ptr = reinterpret_cast<char *>(tx->getWritePointer());
+            if (!this->isMachineMode()) {
+                return CommandContextInterface::outputSpan_t{ptr, this->getTxSpace()};
+            }
+
+            // Machine mode: leave room for the frame around the output
+            if (tx->getRemainingSpace() <= MachineProtocol::OVERHEAD) {
+                return CommandContextInterface::outputSpan_t{ptr, 0};
+            }
+            return CommandContextInterface::outputSpan_t{
+                ptr + MachineProtocol::HEADER_LEN, tx->getRemainingSpace() - MachineProtocol::OVERHEAD
+            };
+        });
+
+        cmdCtx.registerOnCommitFunction([this](size_t len) {
+            auto *tx = this->getTxBuffer();
+            if (!this->isMachineMode()) {
+                tx->setWrittenBytes(this->escapeTx(len));
+                return;
+            }
+            if (len == 0) return;
+            tx->setWrittenBytes(MachineProtocol::frame(
+                tx->getWritePointer(), this->cmdSeq, static_cast<uint8_t>(MachineProtocol::status::OUTPUT), len));
+        });
+
+        cmdCtx.registerOnCmdEndFunction([this]() {
+            // Debugger_log(DBG, "onCmdEndFn()");
+        });
+
+        cmdCtx.do_preFlightCheck();
+        cmdCtx.do_init();
+        if (cmdCtx.isCmdSync()) {
+            cmdCtx.do_run();
+            cmdCtx.do_cleanup();
+            // Recycles the command, or keeps it until its output has drained
+            runCommand();
+            return;
         }
+
+        // Asynchronous command, stepped from loop() until finished
+        runCommand();
+        return;
     }
 
     // So something useful with the tokens
 
-    this->getTxBuffer()->printf("ERROR: Command '%s' not found\r\n", argv[0]);
+    respondError(seq, MachineProtocol::status::ERR_UNKNOWN_COMMAND,
+                 "ERROR: Command '%s' not found\r\n", argc > 0 ? argv[0] : "");
+}
+
+void Shell::respondError(const uint8_t seq, const MachineProtocol::status status,
+                         const char *format, const char *name) {
+    if (isMachineMode()) {
+        respond(seq, status);
+        return;
+    }
+
+    // The name is user input, it may contain 0xff
+    char text[MICRORL_CFG_CMDLINE_LEN + 64];
+    const auto len = snprintf(text, sizeof text, format, name);
+    if (len > 0) {
+        writeEscaped(reinterpret_cast<const uint8_t *>(text), std::min(static_cast<size_t>(len), sizeof text - 1));
+    }
+}
+
+int Shell::copyArgs(int argc, const char *const *argv) {
+    argc = packArgs(argc, argv, argBuffer, sizeof argBuffer);
+    unpackArgs(argc);
+    return argc;
+}
+
+int Shell::packArgs(int argc, const char *const *argv, char *buf, const size_t size) {
+    size_t pos = 0;
+    int count = 0;
+    for (; count < argc && count < MICRORL_CFG_CMD_TOKEN_NMB && pos < size; count++) {
+        const auto len = std::min(strlen(argv[count]), size - pos - 1);
+        memcpy(buf + pos, argv[count], len);
+        buf[pos + len] = '\0';
+        pos += len + 1;
+    }
+    return count;
+}
+
+void Shell::unpackArgs(const int argc) {
+    const char *p = argBuffer;
+    for (int i = 0; i < argc; i++) {
+        argvBuffer[i] = p;
+        p += strlen(p) + 1;
+    }
+}
+
+bool Shell::queueCommand(const int argc, const char *const *argv, const uint8_t seq) {
+    if (cmdQueueCount == std::size(cmdQueue)) return false;
+    auto &entry = cmdQueue[(cmdQueueHead + cmdQueueCount) % std::size(cmdQueue)];
+    entry.argc = packArgs(argc, argv, entry.args, sizeof entry.args);
+    entry.seq = seq;
+    cmdQueueCount++;
+    return true;
+}
+
+void Shell::startQueuedCommands() {
+    while (!cmdCtx.hasCommand() && cmdQueueCount > 0) {
+        const auto &entry = cmdQueue[cmdQueueHead];
+        memcpy(argBuffer, entry.args, sizeof argBuffer);
+        const auto argc = entry.argc;
+        const auto seq = entry.seq;
+        cmdQueueHead = (cmdQueueHead + 1) % std::size(cmdQueue);
+        cmdQueueCount--;
+
+        unpackArgs(argc);
+        startCommand(argc, seq);
+    }
+}
+
+size_t Shell::machineInput(const uint8_t *data, const size_t len) {
+    size_t used = 0;
+    while (used < len && isMachineMode()) {
+        if (frameParser.isIdle() && data[used] != MachineProtocol::SOF) {
+            // Between frames: Ctrl+C aborts like CMD_ABORT, anything else is garbage
+            if (data[used++] == MachineProtocol::CTRL_C) {
+                sigintCallback();
+            } else {
+                garbageReceived();
+            }
+            continue;
+        }
+
+        MachineFrameParser::parseResult result;
+        used += frameParser.parse(data + used, len - used, result);
+        if (result == MachineFrameParser::parseResult::FRAME) {
+            machineGarbage.clear();
+            executeFrame();
+        } else if (result == MachineFrameParser::parseResult::ERROR) {
+            garbageReceived();
+            respond(0, MachineProtocol::status::ERR_FRAME);
+        }
+    }
+    return used;
+}
+
+void Shell::garbageReceived() {
+    if (machineGarbage.isArmed()) return;
+    machineGarbage.set(CommandContext::getClock()->micros(), LIBSMART_STM32SHELL_MACHINE_GARBAGE_TIMEOUT * 1000UL);
+}
+
+void Shell::leaveMachineMode() {
+    frameParser.reset();
+    machineGarbage.clear();
+    listActive = false;
+    setMachineMode(false);
+}
+
+void Shell::executeFrame() {
+    const auto seq = frameParser.getSeq();
+    const auto id = frameParser.getCommand();
+
+    switch (id) {
+        case MachineProtocol::CMD_LIST:
+            // Streamed by stepList() as the TX buffer drains
+            if (listActive) {
+                respond(seq, MachineProtocol::status::ERR_BUSY);
+                return;
+            }
+            listActive = true;
+            listSeq = seq;
+            listIndex = 0;
+            if (responder.getPending() == 0) stepList();
+            return;
+
+        case MachineProtocol::CMD_ABORT:
+            sigintCallback();
+            respond(seq, MachineProtocol::status::OK);
+            return;
+
+        case MachineProtocol::CMD_EXIT:
+            // The OK must be out before the line editor prints its prompt
+            if (cmdCtx.hasCommand() || cmdQueueCount > 0 || listActive || responder.getPending() > 0
+                || !sendFrame(seq, MachineProtocol::status::OK, nullptr, 0)) {
+                respond(seq, MachineProtocol::status::ERR_BUSY);
+                return;
+            }
+            leaveMachineMode();
+            return;
+
+        default:
+            break;
+    }
+
+    auto *cmd = cmdRegistry.at(id);
+    if (cmd == nullptr) {
+        respond(seq, MachineProtocol::status::ERR_UNKNOWN_COMMAND);
+        return;
+    }
+
+    // Arguments are length prefixed, so no tokenizing is needed
+    char args[MICRORL_CFG_CMDLINE_LEN + 1];
+    const char *argv[MICRORL_CFG_CMD_TOKEN_NMB];
+    int argc = 0;
+    size_t pos = 0;
+    argv[argc++] = cmd->getName();
+
+    const auto *p = frameParser.getPayload();
+    const auto *end = p + frameParser.getPayloadLength();
+    while (p < end) {
+        const size_t len = *p++;
+        if (len > static_cast<size_t>(end - p) || argc == MICRORL_CFG_CMD_TOKEN_NMB || pos + len >= sizeof args) {
+            static constexpr char error[] = "invalid argument list";
+            respond(seq, MachineProtocol::status::ERR_ARGUMENTS, error);
+            return;
+        }
+        memcpy(args + pos, p, len);
+        args[pos + len] = '\0';
+        argv[argc++] = args + pos;
+        pos += len + 1;
+        p += len;
+    }
+
+    dispatch(argc, argv, seq);
+}
+
+bool Shell::sendFrame(const uint8_t seq, const MachineProtocol::status status, const void *payload,
+                      const size_t len) {
+    return responder.send(getTxBuffer(), seq, status, payload, len);
+}
+
+void Shell::respond(const uint8_t seq, const MachineProtocol::status status, const char *message) {
+    if (responder.respond(getTxBuffer(), seq, status, message)) return;
+    LIBSMART_STM32SHELL_LOG(ERROR)
+            ->printf("Stm32Shell::ezShell::Shell::respond status 0x%02x for %u dropped\r\n",
+                     static_cast<unsigned>(status), static_cast<unsigned>(seq));
+}
+
+bool Shell::sendPendingStatus() {
+    return responder.flush(getTxBuffer());
+}
+
+void Shell::stepList() {
+    if (!listActive) return;
+
+    // One OUTPUT frame per command: id, name
+    uint8_t entry[LIBSMART_STM32SHELL_MACHINE_MAX_FRAME];
+    for (; listIndex < cmdRegistry.size(); listIndex++) {
+        const auto *name = cmdRegistry.at(listIndex)->getName();
+        const auto nameLen = std::min(strlen(name), sizeof entry - 1);
+        entry[0] = static_cast<uint8_t>(listIndex);
+        memcpy(entry + 1, name, nameLen);
+        if (sendFrame(listSeq, MachineProtocol::status::OUTPUT, entry, nameLen + 1)) continue;
+
+        // Continued by loop() when the transport has made room, unless it never fits
+        if (getTxBuffer()->getLength() > 0) return;
+        listActive = false;
+        respond(listSeq, MachineProtocol::status::ERR_OVERFLOW);
+        return;
+    }
+    listActive = false;
+    respond(listSeq, MachineProtocol::status::OK);
+}
+
+bool Shell::sendStatus() {
+    const char *message = nullptr;
+    auto status = MachineProtocol::status::OK;
+    switch (cmdCtx.getResult()) {
+        case CommandContext::result::OK:
+            break;
+        case CommandContext::result::ARGUMENT_ERROR:
+            status = MachineProtocol::status::ERR_ARGUMENTS;
+            message = cmdCtx.cmd->getArgumentError();
+            break;
+        case CommandContext::result::PREFLIGHTCHECK_ERROR:
+            status = MachineProtocol::status::ERR_PREFLIGHTCHECK;
+            break;
+        case CommandContext::result::INIT_ERROR:
+            status = MachineProtocol::status::ERR_INIT;
+            break;
+        case CommandContext::result::RUN_ERROR:
+            status = MachineProtocol::status::ERR_RUN;
+            break;
+        case CommandContext::result::RUN_TIMEOUT:
+            status = MachineProtocol::status::ERR_TIMEOUT;
+            break;
+        case CommandContext::result::TERMINATED:
+            status = MachineProtocol::status::TERMINATED;
+            break;
+    }
+    return sendFrame(cmdSeq, status, message, message == nullptr ? 0 : strlen(message));
+}
+
+char **Shell::completeCallback(int argc, const char *const *argv) {
+    size_t found = 0;
+    const auto maxFound = std::size(completions) - 1;
+
+    if (argc <= 1) {
+        // Complete the command name from the sorted registry
+        const char *prefix = argc == 1 ? argv[0] : "";
+        const auto len = strlen(prefix);
+        for (auto i = cmdRegistry.lowerBoundPrefix(prefix, len); i < cmdRegistry.size() && found < maxFound; i++) {
+            const auto name = cmdRegistry.at(i)->getName();
+            if (strncmp(name, prefix, len) != 0) break;
+            completions[found++] = name;
+        }
+    } else if (auto *cmd = cmdRegistry.find(argv[0])) {
+        // Complete an argument from the vocabulary of the command
+        const auto vocabulary = cmd->getVocabulary(argc - 1);
+        const char *prefix = argv[argc - 1];
+        const auto len = strlen(prefix);
+        size_t lo = 0;
+        size_t hi = vocabulary.count;
+        while (lo < hi) {
+            const auto mid = lo + (hi - lo) / 2;
+            if (strncmp(vocabulary.words[mid], prefix, len) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (; lo < vocabulary.count && found < maxFound; lo++) {
+            if (strncmp(vocabulary.words[lo], prefix, len) != 0) break;
+            completions[found++] = vocabulary.words[lo];
+        }
+    }
+
+    completions[found] = nullptr;
+    return const_cast<char **>(completions);
+}
+
+void Shell::sigintCallback() {
+    // Ctrl+C aborts the whole pipeline
+    if (cmdQueueCount > 0) {
+        if (isMachineMode()) {
+            for (size_t i = 0; i < cmdQueueCount; i++) {
+                respond(cmdQueue[(cmdQueueHead + i) % std::size(cmdQueue)].seq,
+                        MachineProtocol::status::TERMINATED);
+            }
+        } else {
+            this->getTxBuffer()->printf("NOTICE: %u queued commands dropped\r\n",
+                                        static_cast<unsigned>(cmdQueueCount));
+        }
+        cmdQueueCount = 0;
+    }
+    if (!cmdCtx.hasCommand()) return;
+    if (!cmdCtx.hasEnded()) {
+        cmdCtx.do_terminate();
+        cmdCtx.do_cleanup();
+    }
+    runCommand();
+}
+
+void Shell::runCommand() {
+    cmdRunnable = false;
+    if (!cmdCtx.hasCommand()) return;
+
+    // Backpressure: the command is suspended until its pending output is in the TX buffer
+    if (cmdCtx.outputLength() > 0) cmdCtx.onWriteFn();
+    if (cmdCtx.outputLength() > 0) return;
+
+    if (!cmdCtx.hasEnded()) {
+        cmdCtx.do_run();
+        if (cmdCtx.isRunning()) {
+            // Run again at once, unless it waits for output space or a deadline
+            cmdRunnable = !cmdCtx.isWaiting();
+            return;
+        }
+        cmdCtx.do_cleanup();
+        if (cmdCtx.outputLength() > 0) return;
+    }
+
+    // Machine mode: the status frame ends the response, wait until it fits
+    if (isMachineMode() && !sendStatus()) return;
+
+    cmdCtx.recycle();
+    releaseCommand();
+    startQueuedCommands();
+}
 
-    return 0; // Everything ok
+void Shell::releaseCommand() {
+    if (ownedCmd != nullptr) ownedCmd->release();
+    ownedCmd = nullptr;
 }
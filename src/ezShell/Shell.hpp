@@ -9,31 +9,252 @@
 #include "Command/CommandInterface.hpp"
 #include "Command/CommandContext.hpp"
 #include "Readline/AbstractMicrorlStreamSession.hpp"
+#include "CommandRegistry.hpp"
+#include "MachineProtocol.hpp"
 
 #define LIBSMART_STM32SHELL_EZSHELL_MAX_PROMPT 100
-#define LIBSMART_STM32SHELL_EZSHELL_MAX_CMD 20
+
+#ifndef LIBSMART_STM32SHELL_EZSHELL_MAX_COMPLETIONS
+#define LIBSMART_STM32SHELL_EZSHELL_MAX_COMPLETIONS 16
+#endif
+
+/** Number of commands that can wait in a session while another command is active */
+#ifndef LIBSMART_STM32SHELL_EZSHELL_COMMAND_QUEUE_SIZE
+#define LIBSMART_STM32SHELL_EZSHELL_COMMAND_QUEUE_SIZE 4
+#endif
+
+/** Number of machine mode status frames that can wait for space in the TX buffer */
+#ifndef LIBSMART_STM32SHELL_EZSHELL_PENDING_STATUS_SIZE
+#define LIBSMART_STM32SHELL_EZSHELL_PENDING_STATUS_SIZE (LIBSMART_STM32SHELL_EZSHELL_COMMAND_QUEUE_SIZE + 4)
+#endif
 
 namespace Stm32Shell::ezShell {
     class Shell : public Readline::AbstractMicrorlStreamSession {
     public:
         void setup() override;
 
+        void loop() override;
+
+        /** Also drops the machine mode responses still waiting for the TX buffer. */
+        void end() override;
+
+        /** @return true also while the active command can make progress without waiting. */
+        bool hasPendingWork() override;
+
+        /** @return Time until the deadline of the active command or the machine mode garbage timeout. */
+        uint32_t getTimeToDeadline(uint32_t now) override;
+
         void setCwd(const char *cwd);
 
+        /**
+         * @brief Adds a command to the registry shared by all sessions.
+         *
+         * The registry is sorted by name. Registering a command after machine mode
+         * clients have listed the commands shifts the ids of all commands behind it.
+         */
         static void registerCmd(Command::CommandInterface *cmd);
 
         static size_t registeredCommands();
 
+        /** @return The registry of all commands, with their metrics. */
+        static CommandRegistry &getCommandRegistry();
+
     protected:
+        /**
+         * @brief Starts a command, or queues it while another command is active.
+         *
+         * Queued commands are started in order as soon as the active command has been
+         * recycled, so a client can send several commands without waiting. Each command
+         * still ends with its own OK or ERROR.
+         */
         int executeCallback(int argc, const char *const *argv) override;
 
+        char **completeCallback(int argc, const char *const *argv) override;
+
+        void sigintCallback() override;
+
+        /**
+         * @brief Executes the request frames of machine mode.
+         *
+         * @return Number of bytes consumed, less than len after the EXIT request.
+         */
+        size_t machineInput(const uint8_t *data, size_t len) override;
+
+        /**
+         * @brief Steps the currently active command.
+         *
+         * Calls run() of an asynchronous command once. When the command has finished,
+         * timed out or failed, it is cleaned up and recycled. As long as output of the
+         * command is waiting for space in the TX buffer, the command is not stepped
+         * and not recycled, so no output is lost.
+         *
+         * Sets cmdRunnable if the command can make progress at once, otherwise the
+         * session waits for the transport or the deadline of the command.
+         *
+         * After recycling, the next queued command is started.
+         */
+        void runCommand();
+
     private:
         char prompt[LIBSMART_STM32SHELL_EZSHELL_MAX_PROMPT] = {};
         const char *cwd = prompt;
 
         Command::CommandContext cmdCtx;
 
-        static std::array<Command::CommandInterface *, LIBSMART_STM32SHELL_EZSHELL_MAX_CMD> cmdRegistry;
+        /** true: the active command ran in the last runCommand() and does not wait. */
+        bool cmdRunnable = false;
+
+        /** Session local command instance created by factory(), nullptr if the prototype is used. */
+        Command::CommandInterface *ownedCmd = nullptr;
+
+        /**
+         * @brief Releases the session local command instance, if there is one.
+         */
+        void releaseCommand();
+
+        /** Copy of the tokens of the active command, microrl reuses its line buffer after executeCallback(). */
+        char argBuffer[MICRORL_CFG_CMDLINE_LEN + 1] = {};
+        const char *argvBuffer[MICRORL_CFG_CMD_TOKEN_NMB] = {};
+
+        /**
+         * @brief Copies the tokens into argBuffer, so they outlive the microrl line buffer.
+         *
+         * @return Number of tokens copied.
+         */
+        int copyArgs(int argc, const char *const *argv);
+
+        /**
+         * @brief Copies the tokens into buf as consecutive '\0' terminated strings.
+         *
+         * @return Number of tokens copied, tokens that do not fit are dropped.
+         */
+        static int packArgs(int argc, const char *const *argv, char *buf, size_t size);
+
+        /**
+         * @brief Points argvBuffer to the tokens packed in argBuffer.
+         */
+        void unpackArgs(int argc);
+
+        /**
+         * @brief Starts a command, or queues it while another command is active.
+         *
+         * @param seq Sequence number of the machine mode request, 0 for the line editor.
+         */
+        void dispatch(int argc, const char *const *argv, uint8_t seq);
+
+        /**
+         * @brief Starts the command whose tokens are in argvBuffer.
+         *
+         * @param seq Sequence number of the machine mode request, 0 for the line editor.
+         */
+        void startCommand(int argc, uint8_t seq);
+
+        /**
+         * @brief Reports an error of a command that could not be started.
+         *
+         * In machine mode as status frame, otherwise as text formatted with the name of the command.
+         */
+        void respondError(uint8_t seq, MachineProtocol::status status, const char *format, const char *name);
+
+        /** A command waiting for the active command to finish. */
+        struct queuedCmd_t {
+            int argc;
+            uint8_t seq;
+            char args[MICRORL_CFG_CMDLINE_LEN + 1];
+        };
+
+        /** Commands waiting for the active command to finish, a ring of cmdQueueCount entries at cmdQueueHead. */
+        queuedCmd_t cmdQueue[LIBSMART_STM32SHELL_EZSHELL_COMMAND_QUEUE_SIZE] = {};
+        size_t cmdQueueHead = 0;
+        size_t cmdQueueCount = 0;
+
+        /**
+         * @brief Appends a command to the queue.
+         *
+         * @return false if the queue is full.
+         */
+        bool queueCommand(int argc, const char *const *argv, uint8_t seq);
+
+        /**
+         * @brief Starts queued commands until one stays active or the queue is empty.
+         */
+        void startQueuedCommands();
+
+        /** Collects the request frames in machine mode. */
+        MachineFrameParser frameParser;
+
+        /** Sequence number of the machine mode request of the active command. */
+        uint8_t cmdSeq = 0;
+
+        /** Writes the response frames, keeps status frames until the TX buffer has room. */
+        MachineResponder<LIBSMART_STM32SHELL_EZSHELL_PENDING_STATUS_SIZE> responder;
+
+        /** true while CMD_LIST is streamed by stepList(). */
+        bool listActive = false;
+        /** Sequence number of the CMD_LIST request. */
+        uint8_t listSeq = 0;
+        /** Next command to list. */
+        size_t listIndex = 0;
+
+        /** Armed by bytes outside of a valid frame, machine mode ends when it expires. */
+        Command::Deadline machineGarbage;
+
+        /**
+         * @brief Executes the request frame in frameParser.
+         */
+        void executeFrame();
+
+        /**
+         * @brief Writes a response frame into the TX buffer.
+         *
+         * @return false if the frame does not fit into the TX buffer.
+         */
+        bool sendFrame(uint8_t seq, MachineProtocol::status status, const void *payload, size_t len);
+
+        /**
+         * @brief Writes a status frame, or keeps it pending until the TX buffer has room.
+         *
+         * Pending frames are sent by loop() in order. If too many are pending, the frame is dropped and logged.
+         *
+         * @param message Payload, must be static text or nullptr.
+         */
+        void respond(uint8_t seq, MachineProtocol::status status, const char *message = nullptr);
+
+        /**
+         * @brief Writes the pending status frames as far as the TX buffer takes them.
+         *
+         * @return true if no status frame is pending anymore.
+         */
+        bool sendPendingStatus();
+
+        /**
+         * @brief Writes the entries of CMD_LIST as far as the TX buffer takes them.
+         *
+         * Ends with OK, or with ERR_OVERFLOW if an entry does not even fit into the empty TX buffer.
+         */
+        void stepList();
+
+        /**
+         * @brief Arms the garbage timeout, if it is not armed yet.
+         */
+        void garbageReceived();
+
+        /**
+         * @brief Returns to the line editor, drops a partially received frame and CMD_LIST.
+         */
+        void leaveMachineMode();
+
+        /**
+         * @brief Writes the status frame of the active command.
+         *
+         * @return false if the frame does not fit into the TX buffer.
+         */
+        bool sendStatus();
+
+        /** Completion candidates returned to microrl, nullptr terminated. */
+        const char *completions[LIBSMART_STM32SHELL_EZSHELL_MAX_COMPLETIONS + 1] = {};
+
+        static CommandRegistry cmdRegistry;
     };
 }
 #endif
@@ -12,5 +12,23 @@
 #define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_BUFFER_SIZE_RX 256
 #define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_BUFFER_SIZE_TX 256
 
+/** Size of the lock-free rings for input and output in interrupt context, a power of two */
+#ifndef LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_RX
+#define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_RX 64
+#endif
+#ifndef LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_TX
+#define LIBSMART_STM32SHELL_MICRORLSTREAMSESSION_ISR_RING_SIZE_TX 64
+#endif
+
+/** Bytes per session for the frames of CoroutineCommand, 0 disables them, see CoroutineArena.hpp */
+#ifndef LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE
+#define LIBSMART_STM32SHELL_COROUTINE_ARENA_SIZE 0
+#endif
+
+/** Log messages above this level are removed at compile time, see Log.hpp */
+#ifndef LIBSMART_STM32SHELL_LOG_LEVEL
+#define LIBSMART_STM32SHELL_LOG_LEVEL LIBSMART_STM32SHELL_LOG_SEVERITY_WARNING
+#endif
+
 
 #endif
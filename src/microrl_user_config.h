@@ -59,6 +59,11 @@ extern "C" {
  */
 #define MICRORL_CFG_USE_ECHO_OFF              1
 
+/**
+ * \brief           Number of tokens in the command. G-code style commands easily have more than 8 parameters.
+ */
+#define MICRORL_CFG_CMD_TOKEN_NMB             16
+
 /**
  * \brief           Enable it, if you want to allow quoting command arguments to include spaces.
  *                  Quoting protects whitespace, for example, 2 quoted tokens:
@@ -66,6 +71,12 @@ extern "C" {
  */
 #define MICRORL_CFG_USE_QUOTING               1
 
+/**
+ * \brief           Enable it, if you want to execute several commands from one line.
+ *                  Automation pipelines "cmd1; cmd2; cmd3" and gets one OK/ERROR per command.
+ */
+#define MICRORL_CFG_USE_COMMAND_SEPARATOR     1
+
 /**
  * \brief           Enable it, if you want to use completion functional, also set completion callback in you code.
  *                  Completion functional calls 'completion' callback if user press 'TAB'.
@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include "Check.hpp"
+#include "Command/Arguments.hpp"
+
+using Stm32Shell::Command::Arguments;
+
+namespace {
+    void testParseInt() {
+        int32_t v = 0;
+        CHECK(Arguments::parseInt("42", v) && v == 42);
+        CHECK(Arguments::parseInt("-12", v) && v == -12);
+        CHECK(Arguments::parseInt("0x1f", v) && v == 0x1f);
+        CHECK(Arguments::parseInt("2147483647", v) && v == INT32_MAX);
+        CHECK(Arguments::parseInt("-2147483648", v) && v == INT32_MIN);
+        CHECK(!Arguments::parseInt("2147483648", v));
+        CHECK(!Arguments::parseInt("0x", v));
+        CHECK(!Arguments::parseInt("12a", v));
+        CHECK(!Arguments::parseInt("", v));
+    }
+
+    void testParseFloat() {
+        float v = 0;
+        CHECK(Arguments::parseFloat("10.5", v) && v == 10.5f);
+        CHECK(Arguments::parseFloat("-0.25", v) && v == -0.25f);
+        CHECK(Arguments::parseFloat("1e3", v) && v == 1000.0f);
+        CHECK(Arguments::parseFloat("25e-1", v) && v == 2.5f);
+        CHECK(Arguments::parseFloat(".5", v) && v == 0.5f);
+        CHECK(!Arguments::parseFloat("1e", v));
+        CHECK(!Arguments::parseFloat(".", v));
+        CHECK(!Arguments::parseFloat("1.5x", v));
+
+        // Out of range, like parseInt() and parseDuration()
+        CHECK(Arguments::parseFloat("3e38", v) && v > 2.9e38f);
+        CHECK(!Arguments::parseFloat("1e40", v));
+        CHECK(!Arguments::parseFloat("-1e40", v));
+        CHECK(!Arguments::parseFloat("1e-50", v));
+        CHECK(Arguments::parseFloat("1e-30", v) && v > 0.0f);
+        CHECK(Arguments::parseFloat("0e-50", v) && v == 0.0f);
+    }
+
+    void testParseDuration() {
+        uint32_t us = 0;
+        CHECK(Arguments::parseDuration("500", us) && us == 500000);
+        CHECK(Arguments::parseDuration("500ms", us) && us == 500000);
+        CHECK(Arguments::parseDuration("20us", us) && us == 20);
+        CHECK(Arguments::parseDuration("1.5s", us) && us == 1500000);
+        CHECK(Arguments::parseDuration("2m", us) && us == 120000000);
+        CHECK(!Arguments::parseDuration("72m", us));
+        CHECK(!Arguments::parseDuration("5h", us));
+        CHECK(!Arguments::parseDuration("-1", us));
+    }
+
+    void testParse() {
+        static const char *const modes[] = {"off", "on"};
+        static const Arguments::spec_t specs[] = {
+            {'M', Arguments::type::ENUM, true, true, modes, 2},
+            {'X', Arguments::type::FLOAT},
+            {'F', Arguments::type::INT},
+            {'T', Arguments::type::DURATION},
+            {'V', Arguments::type::FLAG},
+        };
+        constexpr size_t specCount = sizeof specs / sizeof specs[0];
+        Arguments args;
+
+        const char *const line[] = {"move", "ON", "x10.5", "F3000", "T1.5s", "v"};
+        CHECK(args.parse(specs, specCount, 6, line));
+        CHECK(args.getError() == nullptr);
+        CHECK(args.getEnum('M') == 1);
+        CHECK(args.getFloat('X') == 10.5f);
+        CHECK(args.getInt('f') == 3000);
+        CHECK(args.getDuration('T') == 1500000);
+        CHECK(args.has('V'));
+
+        const char *const defaults[] = {"move", "off"};
+        CHECK(args.parse(specs, specCount, 2, defaults));
+        CHECK(!args.has('X'));
+        CHECK(args.getInt('F', 7) == 7);
+
+        const char *const missing[] = {"move", "X1"};
+        CHECK(!args.parse(specs, specCount, 2, missing));
+        CHECK(args.getError() != nullptr && std::strcmp(args.getError(), "missing argument 'M'") == 0);
+
+        const char *const duplicate[] = {"move", "on", "X1", "X2"};
+        CHECK(!args.parse(specs, specCount, 4, duplicate));
+        CHECK(std::strcmp(args.getError(), "duplicate argument 'X2'") == 0);
+
+        const char *const invalid[] = {"move", "on", "Fabc"};
+        CHECK(!args.parse(specs, specCount, 3, invalid));
+        CHECK(std::strcmp(args.getError(), "invalid argument 'Fabc'") == 0);
+
+        const char *const unexpected[] = {"move", "on", "off"};
+        CHECK(!args.parse(specs, specCount, 3, unexpected));
+        CHECK(std::strcmp(args.getError(), "unexpected argument 'off'") == 0);
+
+        args.clear();
+        CHECK(args.getError() == nullptr);
+        CHECK(!args.has('M'));
+    }
+}
+
+int main() {
+    testParseInt();
+    testParseFloat();
+    testParseDuration();
+    testParse();
+    return Stm32Shell::Test::result();
+}
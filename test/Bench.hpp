@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_TEST_BENCH_HPP
+#define LIBSMART_STM32SHELL_TEST_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Stm32Shell::Test {
+    /**
+     * @brief Minimal benchmark runner.
+     *
+     * Runs a function a fixed number of times and prints the time per
+     * operation, and the throughput if the function processes bytes.
+     * The number of iterations can be scaled by the first program argument,
+     * so ctest runs a short smoke pass and a manual run can measure longer.
+     */
+    class Bench {
+    public:
+        Bench(const int argc, char **argv) {
+            if (argc > 1) scale = std::strtod(argv[1], nullptr);
+            if (scale <= 0.0) scale = 1.0;
+        }
+
+        /**
+         * @brief Measures a function.
+         *
+         * @param name       Name printed in the report.
+         * @param iterations Number of calls at scale 1.
+         * @param bytesPerOp Bytes processed per call, 0 to omit the throughput.
+         * @param fn         The function to measure.
+         * @return Time per call [ns].
+         */
+        template<typename Fn>
+        double run(const char *name, const uint64_t iterations, const uint64_t bytesPerOp, Fn &&fn) {
+            auto n = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+            if (n == 0) n = 1;
+
+            const auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < n; i++) fn();
+            const auto end = std::chrono::steady_clock::now();
+
+            const auto ns = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(n);
+            if (bytesPerOp > 0) {
+                std::printf("%-40s %12.1f ns/op %12.2f MB/s\n", name, ns,
+                            static_cast<double>(bytesPerOp) * 1e3 / ns);
+            } else {
+                std::printf("%-40s %12.1f ns/op\n", name, ns);
+            }
+            return ns;
+        }
+
+    private:
+        double scale = 1.0;
+    };
+
+    /** @brief Keeps the compiler from optimizing a result away. */
+    template<typename T>
+    void doNotOptimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_TEST_CHECK_HPP
+#define LIBSMART_STM32SHELL_TEST_CHECK_HPP
+
+#include <cstdio>
+
+namespace Stm32Shell::Test {
+    /** Number of failed checks of the test program. */
+    inline int failures = 0;
+
+    /**
+     * @brief Reports a failed check.
+     *
+     * @return false, so a test can return early.
+     */
+    inline bool fail(const char *file, const int line, const char *expr) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+        failures++;
+        return false;
+    }
+
+    /** @return Exit code of the test program. */
+    inline int result() {
+        if (failures > 0) std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+/** Checks a condition and continues with the test if it fails. */
+#define CHECK(expr) ((expr) ? true : Stm32Shell::Test::fail(__FILE__, __LINE__, #expr))
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include "Check.hpp"
+#include "Command/CommandMetrics.hpp"
+
+using Stm32Shell::Command::CommandMetrics;
+using phase = CommandMetrics::phase;
+
+namespace {
+    void testBuckets() {
+        CHECK(CommandMetrics::bucketOf(0) == 0);
+        CHECK(CommandMetrics::bucketOf(3) == 0);
+        CHECK(CommandMetrics::bucketOf(4) == 1);
+        CHECK(CommandMetrics::bucketOf(15) == 1);
+        CHECK(CommandMetrics::bucketOf(16) == 2);
+        CHECK(CommandMetrics::bucketOf(UINT32_MAX) == CommandMetrics::BUCKET_COUNT - 1);
+        for (size_t b = 0; b + 1 < CommandMetrics::BUCKET_COUNT; b++) {
+            CHECK(CommandMetrics::bucketOf(CommandMetrics::bucketLimit(b) - 1) == b);
+            CHECK(CommandMetrics::bucketOf(CommandMetrics::bucketLimit(b)) == b + 1);
+        }
+    }
+
+    void testRecord() {
+        CommandMetrics m;
+        const auto &run = m.getHistogram(phase::RUN);
+        CHECK(run.count() == 0);
+        CHECK(run.mean() == 0);
+
+        m.record(phase::RUN, 10);
+        m.record(phase::RUN, 30);
+        m.record(phase::RUN, 2);
+        CHECK(run.count() == 3);
+        CHECK(run.min == 2);
+        CHECK(run.max == 30);
+        CHECK(run.mean() == 14);
+        CHECK(run.buckets[0] == 1 && run.buckets[1] == 1 && run.buckets[2] == 1);
+        CHECK(m.getHistogram(phase::INIT).count() == 0);
+
+        m.countInvocation();
+        m.countError();
+        m.countTimeout();
+        m.countTermination();
+        CHECK(m.getInvocations() == 1 && m.getErrors() == 1);
+        CHECK(m.getTimeouts() == 1 && m.getTerminations() == 1);
+
+        m.reset();
+        CHECK(m.getInvocations() == 0);
+        CHECK(run.count() == 0 && run.min == UINT32_MAX);
+    }
+
+    void testPhaseNames() {
+        CHECK(std::strcmp(CommandMetrics::phaseName(phase::PREFLIGHTCHECK), "preflightcheck") == 0);
+        CHECK(std::strcmp(CommandMetrics::phaseName(phase::CLEANUP), "cleanup") == 0);
+    }
+}
+
+int main() {
+    testBuckets();
+    testRecord();
+    testPhaseNames();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include "Check.hpp"
+#include "Command/CommandPool.hpp"
+
+using Stm32Shell::Command::CommandPool;
+using Stm32Shell::Command::CommandPoolInterface;
+
+namespace {
+    /** Counts its constructions and destructions. */
+    struct Counted {
+        inline static int constructed = 0;
+        inline static int destroyed = 0;
+
+        int value = 42;
+
+        Counted() { constructed++; }
+        ~Counted() { destroyed++; }
+    };
+
+    void testExhaustion() {
+        CommandPool<Counted, 2> pool;
+        CHECK(pool.getCapacity() == 2);
+        auto *a = pool.allocate();
+        auto *b = pool.allocate();
+        CHECK(a != nullptr && b != nullptr && a != b);
+        CHECK(a->value == 42 && b->value == 42);
+        CHECK(pool.getUsed() == 2);
+        CHECK(pool.getFailures() == 0);
+
+        CHECK(pool.allocate() == nullptr);
+        CHECK(pool.allocate() == nullptr);
+        CHECK(pool.getFailures() == 2);
+        CHECK(pool.getUsed() == 2);
+    }
+
+    void testReuse() {
+        CommandPool<Counted, 3> pool;
+        auto *a = pool.allocate();
+        auto *b = pool.allocate();
+        const auto constructed = Counted::constructed;
+        const auto destroyed = Counted::destroyed;
+
+        // The slot freed last is allocated first, constructed again
+        a->value = 1;
+        pool.free(a);
+        CHECK(Counted::destroyed == destroyed + 1);
+        CHECK(pool.getUsed() == 1);
+        auto *c = pool.allocate();
+        CHECK(c == a);
+        CHECK(c->value == 42);
+        CHECK(Counted::constructed == constructed + 1);
+
+        // All slots can be used after frees in any order
+        pool.free(b);
+        pool.free(c);
+        CHECK(pool.getUsed() == 0);
+        Counted *all[3];
+        for (auto &obj: all) obj = pool.allocate();
+        CHECK(all[0] != nullptr && all[1] != nullptr && all[2] != nullptr);
+        CHECK(all[0] != all[1] && all[1] != all[2] && all[0] != all[2]);
+        CHECK(pool.allocate() == nullptr);
+    }
+
+    void testForeignFree() {
+        CommandPool<Counted, 2> pool;
+        CommandPool<Counted, 2> other;
+        auto *a = pool.allocate();
+        auto *foreign = other.allocate();
+        Counted local;
+        const auto destroyed = Counted::destroyed;
+
+        pool.free(nullptr);
+        pool.free(foreign);
+        pool.free(&local);
+        // Inside the storage, but not at the start of a slot
+        pool.free(reinterpret_cast<Counted *>(reinterpret_cast<unsigned char *>(a) + 1));
+        CHECK(Counted::destroyed == destroyed);
+        CHECK(pool.getUsed() == 1);
+        CHECK(other.getUsed() == 1);
+
+        // The free list is intact
+        CHECK(pool.allocate() != nullptr);
+        CHECK(pool.allocate() == nullptr);
+    }
+
+    void testHighWater() {
+        CommandPool<Counted, 4> pool;
+        CHECK(pool.getHighWater() == 0);
+        auto *a = pool.allocate();
+        auto *b = pool.allocate();
+        auto *c = pool.allocate();
+        CHECK(pool.getHighWater() == 3);
+
+        pool.free(a);
+        pool.free(b);
+        CHECK(pool.getUsed() == 1);
+        CHECK(pool.getHighWater() == 3);
+
+        a = pool.allocate();
+        CHECK(pool.getHighWater() == 3);
+        pool.free(a);
+        pool.free(c);
+        CHECK(pool.getHighWater() == 3);
+    }
+
+    void testPoolList() {
+        CommandPool<Counted, 1> first;
+        CommandPool<Counted, 1> second;
+        first.setName("first");
+        second.setName("second");
+
+        // The latest pool is at the front
+        CHECK(CommandPoolInterface::first() == &second);
+        CHECK(second.getNext() == &first);
+        CHECK(std::strcmp(CommandPoolInterface::first()->getName(), "second") == 0);
+    }
+}
+
+int main() {
+    testExhaustion();
+    testReuse();
+    testForeignFree();
+    testHighWater();
+    testPoolList();
+    return Stm32Shell::Test::result();
+}
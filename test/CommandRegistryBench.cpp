@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Command lookup time versus number of commands: the binary search of
+ * CommandRegistry against the linear strcmp() scan it replaced.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Bench.hpp"
+#include "ezShell/CommandRegistry.hpp"
+
+using Stm32Shell::Command::CommandContextInterface;
+using Stm32Shell::Command::CommandInterface;
+using Stm32Shell::ezShell::CommandRegistry;
+using Stm32Shell::Test::Bench;
+using Stm32Shell::Test::doNotOptimize;
+
+namespace {
+    /** Command that only has a name. */
+    class NamedCommand final : public CommandInterface {
+    public:
+        explicit NamedCommand(const char *name) { setName(name); }
+
+        preFlightCheckReturn preFlightCheck() override { return preFlightCheckReturn::READY; }
+        initReturn init() override { return initReturn::READY; }
+        runReturn run() override { return runReturn::FINISHED; }
+        cleanupReturn cleanup() override { return cleanupReturn::OK; }
+        void terminate() override {}
+        void recycle() override {}
+        const char *getCommandLine() override { return ""; }
+        bool isCmdSync() override { return true; }
+        uint32_t getRunTimeout() override { return 0; }
+        void setParam(int, const char *const *) override {}
+        CommandInterface *factory() override { return nullptr; }
+        void release() override {}
+        CommandContextInterface *getCommandContext() override { return nullptr; }
+
+    protected:
+        void onRunTimeout() override {}
+        void onRunError() override {}
+        void onRunFinished() override {}
+        void onCleanupFinished() override {}
+        void onCmdEnd() override {}
+
+    private:
+        void setContext(CommandContextInterface *) override {}
+    };
+
+    /** Lookup as done before the registry was sorted. */
+    CommandInterface *linearFind(const std::vector<CommandInterface *> &commands, const char *name) {
+        for (auto *cmd: commands) {
+            if (std::strcmp(cmd->getName(), name) == 0) return cmd;
+        }
+        return nullptr;
+    }
+}
+
+int main(const int argc, char **argv) {
+    Bench bench(argc, argv);
+    int ret = 0;
+
+    for (const size_t count: {8, 32, 128, 512}) {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; i++) names.push_back("cmd" + std::to_string(i * 7919 % 100000));
+
+        std::vector<std::unique_ptr<NamedCommand> > commands;
+        std::vector<CommandInterface *> linear;
+        CommandRegistry registry;
+        for (const auto &name: names) {
+            commands.push_back(std::make_unique<NamedCommand>(name.c_str()));
+            linear.push_back(commands.back().get());
+            if (registry.add(commands.back().get()) != CommandRegistry::addReturn::OK) ret = 1;
+        }
+
+        // Every command once per operation, so the position does not matter
+        char label[48];
+        std::snprintf(label, sizeof label, "registry.find/%zu", count);
+        const auto sorted = bench.run(label, 200000 / count, 0, [&] {
+            for (const auto &name: names) doNotOptimize(registry.find(name.c_str()));
+        }) / static_cast<double>(count);
+
+        std::snprintf(label, sizeof label, "linear strcmp/%zu", count);
+        const auto scan = bench.run(label, 200000 / count, 0, [&] {
+            for (const auto &name: names) doNotOptimize(linearFind(linear, name.c_str()));
+        }) / static_cast<double>(count);
+
+        std::printf("%zu commands: %.1f ns vs %.1f ns per lookup\n", count, sorted, scan);
+
+        for (const auto &name: names) {
+            if (registry.find(name.c_str()) != linearFind(linear, name.c_str())) ret = 1;
+        }
+    }
+    return ret;
+}
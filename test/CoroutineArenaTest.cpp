@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstddef>
+#include "Check.hpp"
+#include "Command/CoroutineArena.hpp"
+
+using Stm32Shell::Command::CoroutineArena;
+using Stm32Shell::Command::StaticCoroutineArena;
+
+namespace {
+    bool isAligned(const void *ptr) {
+        return reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+    }
+
+    void testStackOrder() {
+        StaticCoroutineArena<256> arena;
+        auto *a = arena.allocate(10);
+        auto *b = arena.allocate(20);
+        CHECK(a != nullptr && b != nullptr);
+        CHECK(isAligned(a) && isAligned(b));
+        CHECK(static_cast<uint8_t *>(b) > static_cast<uint8_t *>(a));
+        const auto used = arena.getUsed();
+
+        CoroutineArena::deallocate(b);
+        CHECK(arena.getUsed() < used);
+        CoroutineArena::deallocate(a);
+        CHECK(arena.getUsed() == 0);
+        CHECK(arena.getHighWater() == used);
+    }
+
+    void testOutOfOrder() {
+        StaticCoroutineArena<256> arena;
+        auto *a = arena.allocate(8);
+        auto *b = arena.allocate(8);
+        const auto used = arena.getUsed();
+
+        // Freed below the top, only marked
+        CoroutineArena::deallocate(a);
+        CHECK(arena.getUsed() == used);
+
+        // Reclaimed together with the frame above
+        CoroutineArena::deallocate(b);
+        CHECK(arena.getUsed() == 0);
+
+        CoroutineArena::deallocate(nullptr);
+    }
+
+    void testFull() {
+        StaticCoroutineArena<128> arena;
+        CHECK(arena.allocate(arena.getCapacity()) == nullptr);
+        CHECK(arena.getFailures() == 1);
+        auto *a = arena.allocate(16);
+        CHECK(a != nullptr);
+        CoroutineArena::deallocate(a);
+        CHECK(arena.getUsed() == 0);
+    }
+
+    void testScope() {
+        StaticCoroutineArena<64> outer;
+        StaticCoroutineArena<64> inner;
+        CHECK(CoroutineArena::getCurrent() == nullptr);
+        {
+            CoroutineArena::scope s1(&outer);
+            CHECK(CoroutineArena::getCurrent() == &outer);
+            {
+                CoroutineArena::scope s2(&inner);
+                CHECK(CoroutineArena::getCurrent() == &inner);
+            }
+            CHECK(CoroutineArena::getCurrent() == &outer);
+        }
+        CHECK(CoroutineArena::getCurrent() == nullptr);
+    }
+}
+
+int main() {
+    testStackOrder();
+    testOutOfOrder();
+    testFull();
+    testScope();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Check.hpp"
+#include "Command/ClockInterface.hpp"
+#include "Command/HostClock.hpp"
+
+using Stm32Shell::Command::Deadline;
+using Stm32Shell::Command::HostClock;
+
+namespace {
+    void testDeadline() {
+        Deadline d;
+        CHECK(!d.isArmed());
+        CHECK(!d.hasExpired(0));
+        CHECK(d.remaining(0) == 0);
+
+        d.set(1000, 500);
+        CHECK(d.isArmed());
+        CHECK(!d.hasExpired(1499));
+        CHECK(d.remaining(1200) == 300);
+        CHECK(d.hasExpired(1500));
+        CHECK(d.remaining(1600) == 0);
+
+        d.clear();
+        CHECK(!d.hasExpired(UINT32_MAX));
+    }
+
+    void testWrap() {
+        Deadline d;
+        d.set(UINT32_MAX - 100, 200);
+        CHECK(!d.hasExpired(UINT32_MAX));
+        CHECK(d.remaining(UINT32_MAX) == 100);
+        CHECK(!d.hasExpired(98));
+        CHECK(d.hasExpired(99));
+    }
+
+    void testMaxTimeout() {
+        // The longest timeout does not expire early, also across the wrap
+        for (const uint32_t start: {0U, 0x80000000U, UINT32_MAX}) {
+            Deadline d;
+            d.set(start, Deadline::MAX_TIMEOUT);
+            CHECK(!d.hasExpired(start));
+            CHECK(!d.hasExpired(start + Deadline::MAX_TIMEOUT - 1));
+            CHECK(d.remaining(start) == Deadline::MAX_TIMEOUT);
+            CHECK(d.hasExpired(start + Deadline::MAX_TIMEOUT));
+        }
+    }
+
+    void testHostClock() {
+        HostClock clock(UINT32_MAX - 10);
+        const auto start = clock.micros();
+        CHECK(clock.since(start) < 1000000);
+        clock.setOffset(5);
+        CHECK(clock.micros() - 5 < 1000000);
+    }
+}
+
+int main() {
+    testDeadline();
+    testWrap();
+    testMaxTimeout();
+    testHostClock();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "Check.hpp"
+#include "ezShell/MachineProtocol.hpp"
+
+using Stm32Shell::ezShell::MachineProtocol;
+using Stm32Shell::ezShell::MachineFrameParser;
+using Stm32Shell::ezShell::MachineResponder;
+using parseResult = MachineFrameParser::parseResult;
+using status = MachineProtocol::status;
+
+namespace {
+    /** Builds a request frame, returns its length. */
+    size_t makeFrame(uint8_t *buf, const uint8_t seq, const uint8_t cmd, const char *args) {
+        const auto len = std::strlen(args);
+        std::memcpy(buf + MachineProtocol::HEADER_LEN, args, len);
+        return MachineProtocol::frame(buf, seq, cmd, len);
+    }
+
+    /** TX buffer of a session, drained by the test instead of a transport. */
+    struct Tx {
+        uint8_t buf[32] = {};
+        size_t length = 0;
+
+        size_t getRemainingSpace() const { return sizeof buf - length; }
+        uint8_t *getWritePointer() { return buf + length; }
+        void setWrittenBytes(const size_t len) { length += len; }
+    };
+
+    /** Parses the frames in the TX buffer, returns the seq and status of each. */
+    std::vector<std::pair<uint8_t, status> > drain(Tx &tx) {
+        std::vector<std::pair<uint8_t, status> > frames;
+        MachineFrameParser parser;
+        size_t used = 0;
+        while (used < tx.length) {
+            auto result = parseResult::INCOMPLETE;
+            used += parser.parse(tx.buf + used, tx.length - used, result);
+            if (result == parseResult::FRAME) frames.emplace_back(parser.getSeq(), static_cast<status>(parser.getCommand()));
+        }
+        tx.length = 0;
+        return frames;
+    }
+
+    void testCrc() {
+        // Check value of CRC-16/CCITT-FALSE
+        const auto *check = reinterpret_cast<const uint8_t *>("123456789");
+        CHECK(MachineProtocol::crc16(check, 9) == 0x29b1);
+        // Continued computation
+        CHECK(MachineProtocol::crc16(check + 4, 5, MachineProtocol::crc16(check, 4)) == 0x29b1);
+    }
+
+    void testParse() {
+        uint8_t frame[64];
+        const auto len = makeFrame(frame, 7, 3, "\x03X10");
+        CHECK(len == 4 + MachineProtocol::OVERHEAD);
+        CHECK(frame[0] == MachineProtocol::SOF);
+
+        // Garbage before the frame is skipped
+        uint8_t stream[80] = {'a', 'b'};
+        std::memcpy(stream + 2, frame, len);
+
+        MachineFrameParser parser;
+        auto result = parseResult::INCOMPLETE;
+        CHECK(parser.parse(stream, 2 + len, result) == 2 + len);
+        CHECK(result == parseResult::FRAME);
+        CHECK(parser.getSeq() == 7);
+        CHECK(parser.getCommand() == 3);
+        CHECK(parser.getPayloadLength() == 4);
+        CHECK(std::memcmp(parser.getPayload(), "\x03X10", 4) == 0);
+
+        // Byte by byte, idle only outside of the frame
+        size_t frames = 0;
+        CHECK(parser.isIdle());
+        for (size_t i = 0; i < len; i++) {
+            CHECK(parser.parse(frame + i, 1, result) == 1);
+            if (result == parseResult::FRAME) frames++;
+            CHECK(parser.isIdle() == (i == len - 1));
+        }
+        CHECK(frames == 1);
+    }
+
+    void testStart() {
+        // Passes the telnet state machine unchanged, and is no text
+        bool hasIac = false;
+        bool hasNul = false;
+        for (const auto b: MachineProtocol::START) {
+            hasIac |= b == 0xff;
+            hasNul |= b == 0x00;
+        }
+        CHECK(!hasIac);
+        CHECK(hasNul);
+        CHECK(sizeof MachineProtocol::START > 1);
+    }
+
+    void testErrors() {
+        uint8_t frame[64];
+        const auto len = makeFrame(frame, 1, 2, "");
+        MachineFrameParser parser;
+        auto result = parseResult::INCOMPLETE;
+
+        frame[len - 1] ^= 0x01;
+        CHECK(parser.parse(frame, len, result) == len);
+        CHECK(result == parseResult::ERROR);
+
+        // Too long, the parser resynchronizes on the next SOF
+        const uint8_t tooLong[] = {MachineProtocol::SOF, 0xff, 0x7f};
+        CHECK(parser.parse(tooLong, sizeof tooLong, result) == sizeof tooLong);
+        CHECK(result == parseResult::ERROR);
+
+        frame[len - 1] ^= 0x01;
+        CHECK(parser.parse(frame, len, result) == len);
+        CHECK(result == parseResult::FRAME);
+    }
+
+    void testResponderFullTx() {
+        Tx tx;
+        MachineResponder<2> responder;
+
+        // A full TX buffer, e.g. by the output of another request
+        tx.length = sizeof tx.buf - MachineProtocol::OVERHEAD + 1;
+        CHECK(responder.respond(&tx, 5, status::ERR_UNKNOWN_COMMAND));
+        CHECK(responder.getPending() == 1);
+        CHECK(tx.length == sizeof tx.buf - MachineProtocol::OVERHEAD + 1);
+
+        // Later status frames queue behind, also if they fit
+        tx.length = 0;
+        CHECK(responder.respond(&tx, 6, status::OK));
+        CHECK(tx.length == 0);
+        CHECK(responder.getPending() == 2);
+        CHECK(!responder.respond(&tx, 7, status::OK));
+
+        CHECK(responder.flush(&tx));
+        CHECK(responder.getPending() == 0);
+        const auto frames = drain(tx);
+        CHECK(frames.size() == 2);
+        CHECK(frames[0] == std::make_pair(uint8_t{5}, status::ERR_UNKNOWN_COMMAND));
+        CHECK(frames[1] == std::make_pair(uint8_t{6}, status::OK));
+
+        // Nothing pending, sent at once
+        CHECK(responder.respond(&tx, 8, status::ERR_ARGUMENTS, "bad"));
+        CHECK(responder.getPending() == 0);
+        CHECK(tx.length == 3 + MachineProtocol::OVERHEAD);
+        CHECK(drain(tx).size() == 1);
+    }
+
+    void testResponderFlushPartial() {
+        Tx tx;
+        MachineResponder<4> responder;
+        tx.length = sizeof tx.buf;
+        for (uint8_t seq = 1; seq <= 3; seq++) CHECK(responder.respond(&tx, seq, status::OK));
+
+        // Room for two frames only, the third stays pending
+        tx.length = sizeof tx.buf - 2 * MachineProtocol::OVERHEAD;
+        CHECK(!responder.flush(&tx));
+        CHECK(responder.getPending() == 1);
+        tx.length = 0;
+        CHECK(responder.flush(&tx));
+        const auto frames = drain(tx);
+        CHECK(frames.size() == 1 && frames[0].first == 3);
+
+        // Dropped when the session ends
+        tx.length = sizeof tx.buf;
+        CHECK(responder.respond(&tx, 4, status::OK));
+        responder.clear();
+        CHECK(responder.getPending() == 0);
+    }
+
+    void testTwoFrames() {
+        uint8_t stream[64];
+        const auto len1 = makeFrame(stream, 1, 10, "");
+        const auto len2 = makeFrame(stream + len1, 2, 11, "\x01" "a");
+
+        MachineFrameParser parser;
+        auto result = parseResult::INCOMPLETE;
+        const auto used = parser.parse(stream, len1 + len2, result);
+        CHECK(used == len1);
+        CHECK(result == parseResult::FRAME && parser.getSeq() == 1);
+        CHECK(parser.parse(stream + used, len2, result) == len2);
+        CHECK(result == parseResult::FRAME && parser.getSeq() == 2 && parser.getCommand() == 11);
+    }
+}
+
+int main() {
+    testCrc();
+    testParse();
+    testErrors();
+    testTwoFrames();
+    testStart();
+    testResponderFullTx();
+    testResponderFlushPartial();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Cost of editing in the middle of a long command line. Built once per
+ * MICRORL_CFG_CMDLINE_LEN, the line is filled up to one character below it.
+ */
+
+#include <cstdio>
+#include <string>
+#include "Bench.hpp"
+#include "MicrorlTerminal.hpp"
+
+using Stm32Shell::Test::Bench;
+using Stm32Shell::Test::MicrorlTerminal;
+
+int main(const int argc, char **argv) {
+    Bench bench(argc, argv);
+    constexpr size_t len = MICRORL_CFG_CMDLINE_LEN - 1;
+
+    MicrorlTerminal t;
+    t.record = false;
+    std::string line;
+    for (size_t i = 0; i < len; i++) line += static_cast<char>('a' + i % 26);
+    t.input(line);
+    // Cursor to the middle of the line
+    for (size_t i = 0; i < len / 2; i++) t.input("\x1b[D");
+
+    char label[48];
+    std::snprintf(label, sizeof label, "insert+backspace/%zu", len + 1);
+    bench.run(label, 200000, 0, [&] {
+        microrl_processing_input(&t, "X\x7f", 2);
+    });
+    auto before = t.outputBytes;
+    microrl_processing_input(&t, "X\x7f", 2);
+    std::printf("%s: %zu output bytes/op\n", label, t.outputBytes - before);
+    if (t.line() != line) return 1;
+
+    // Two records that differ in the last character only
+    auto other = line;
+    other.back() = '#';
+    t.input("\r");
+    t.input(other + "\r");
+    t.input("\x1b[A");
+    std::snprintf(label, sizeof label, "history up+down/%zu", len + 1);
+    bench.run(label, 200000, 0, [&] {
+        microrl_processing_input(&t, "\x1b[A\x1b[B", 6);
+    });
+    before = t.outputBytes;
+    microrl_processing_input(&t, "\x1b[A\x1b[B", 6);
+    std::printf("%s: %zu output bytes/op\n", label, t.outputBytes - before);
+
+    return t.line() == other ? 0 : 1;
+}
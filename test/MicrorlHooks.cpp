@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * The command hooks of microrl_user_config.h are provided by
+ * AbstractMicrorlStreamSession on target. On the host they do nothing.
+ */
+
+#include <microrl.h>
+
+namespace {
+    void preCommand(microrl_t *, int, const char *const *) {
+    }
+
+    void postCommand(microrl_t *, int, int, const char *const *) {
+    }
+}
+
+microrl_pre_cmd_fn getPreCommandCallbackPointer() {
+    return preCommand;
+}
+
+microrl_post_cmd_fn getPostCommandCallbackPointer() {
+    return postCommand;
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Throughput of microrl_processing_input() for a pasted script, fed as
+ * whole spans like the session does and one byte per call as before.
+ */
+
+#include <cstdio>
+#include <string>
+#include "Bench.hpp"
+#include "MicrorlTerminal.hpp"
+
+using Stm32Shell::Test::Bench;
+using Stm32Shell::Test::MicrorlTerminal;
+
+namespace {
+    /** A burst of scripted G-code style commands, as pasted into a telnet session. */
+    std::string makeScript() {
+        std::string script;
+        for (int i = 0; i < 64; i++) {
+            script += "move X" + std::to_string(i) + ".5 Y-" + std::to_string(i * 3) + " F3000 T150ms\r\n";
+        }
+        return script;
+    }
+}
+
+int main(const int argc, char **argv) {
+    Bench bench(argc, argv);
+    const auto script = makeScript();
+
+    MicrorlTerminal t;
+    t.record = false;
+    const auto span = bench.run("microrl_processing_input/span", 2000, script.size(), [&] {
+        microrl_processing_input(&t, script.data(), script.size());
+    });
+
+    MicrorlTerminal b;
+    b.record = false;
+    const auto bytes = bench.run("microrl_processing_input/byte", 2000, script.size(), [&] {
+        for (const char ch: script) microrl_processing_input(&b, &ch, 1);
+    });
+    std::printf("span speedup %.2fx\n", bytes / span);
+
+    // Both paths must produce the same session output
+    if (t.outputBytes != b.outputBytes || t.commandCount != b.commandCount) return 1;
+
+    return t.commandCount > 0 ? 0 : 1;
+}
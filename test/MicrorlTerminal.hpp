@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_TEST_MICRORLTERMINAL_HPP
+#define LIBSMART_STM32SHELL_TEST_MICRORLTERMINAL_HPP
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <microrl.h>
+
+namespace Stm32Shell::Test {
+    /**
+     * @brief microrl instance that records its output and the executed commands.
+     *
+     * Stands in for a session: the output goes to a string instead of the TX
+     * buffer, each executed command is stored with its tokens joined by '|'.
+     */
+    struct MicrorlTerminal : microrl_t {
+        std::string output;
+        std::vector<std::string> commands;
+        /** false: output and commands are counted only, for benchmarks. */
+        bool record = true;
+        size_t outputBytes = 0;
+        size_t commandCount = 0;
+
+        MicrorlTerminal() : microrl_t() {
+            microrl_init(this, outputCb, execCb);
+        }
+
+        microrlr_t input(const std::string &str) {
+            return microrl_processing_input(this, str.data(), str.size());
+        }
+
+        std::string line() const { return {cmdline_str, cmdlen}; }
+
+    private:
+        static int outputCb(microrl *mrl, const char *str) {
+            auto *self = static_cast<MicrorlTerminal *>(mrl);
+            const auto len = std::strlen(str);
+            self->outputBytes += len;
+            if (self->record) self->output.append(str, len);
+            return static_cast<int>(len);
+        }
+
+        static int execCb(microrl *mrl, const int argc, const char *const *argv) {
+            auto *self = static_cast<MicrorlTerminal *>(mrl);
+            self->commandCount++;
+            if (self->record) {
+                std::string cmd;
+                for (int i = 0; i < argc; i++) {
+                    if (i > 0) cmd += '|';
+                    cmd += argv[i];
+                }
+                self->commands.push_back(cmd);
+            }
+            return 0;
+        }
+    };
+}
+
+#endif
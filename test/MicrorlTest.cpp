@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Check.hpp"
+#include "MicrorlTerminal.hpp"
+
+using Stm32Shell::Test::MicrorlTerminal;
+
+namespace {
+    void testExecute() {
+        MicrorlTerminal t;
+        CHECK(t.input("led on\r\n") == microrlOK);
+        CHECK(t.commands.size() == 1 && t.commands[0] == "led|on");
+        CHECK(t.output.find("led on") != std::string::npos);
+        CHECK(t.line().empty());
+
+        // CR LF is one newline, an empty line executes nothing
+        CHECK(t.input("\r\n\r\n") == microrlOK);
+        CHECK(t.commands.size() == 1);
+    }
+
+    void testSeparatorAndQuoting() {
+        MicrorlTerminal t;
+        t.input("a 1; b \"x y\";; c\r");
+        CHECK(t.commands.size() == 3);
+        CHECK(t.commands[0] == "a|1");
+        CHECK(t.commands[1] == "b|x y");
+        CHECK(t.commands[2] == "c");
+    }
+
+    void testEditing() {
+        MicrorlTerminal t;
+        t.input("helo");
+        // Cursor left, insert in the middle
+        t.input("\x1b[Dl");
+        CHECK(t.line() == "hello");
+        // Backspace in the middle, Ctrl+A, delete
+        t.input("\x7f");
+        CHECK(t.line() == "helo");
+        t.input("\x01\x1b[3~");
+        CHECK(t.line() == "elo");
+        // Ctrl+E, Ctrl+U clears the line
+        t.input("\x05\x15");
+        CHECK(t.line().empty());
+    }
+
+    void testHistory() {
+        MicrorlTerminal t;
+        t.input("first\r");
+        t.input("second\r");
+        t.input("\x1b[A");
+        CHECK(t.line() == "second");
+        t.input("\x1b[A");
+        CHECK(t.line() == "first");
+        t.input("\x1b[B");
+        CHECK(t.line() == "second");
+        t.input("\r");
+        CHECK(t.commands.size() == 3 && t.commands[2] == "second");
+        CHECK(microrl_hist_records(&t) == 2);
+    }
+
+    void testFullLine() {
+        MicrorlTerminal t;
+        const std::string tooLong(MICRORL_CFG_CMDLINE_LEN + 5, 'x');
+        CHECK(t.input(tooLong) == microrlERRCLFULL);
+        CHECK(t.line().size() == MICRORL_CFG_CMDLINE_LEN);
+    }
+
+    void testSpanEqualsBytes() {
+        // Feeding the input at once or byte by byte makes no difference
+        const std::string script = "set X1 Y2\r\x1b[Aab\x7f\x1b[D\x1b[Dz\r\x15q\r";
+        MicrorlTerminal whole;
+        MicrorlTerminal bytes;
+        whole.input(script);
+        for (const char ch: script) bytes.input(std::string(1, ch));
+        CHECK(whole.commands == bytes.commands);
+        CHECK(whole.output == bytes.output);
+        CHECK(whole.commands.size() == 3);
+    }
+}
+
+int main() {
+    testExecute();
+    testSeparatorAndQuoting();
+    testEditing();
+    testHistory();
+    testFullLine();
+    testSpanEqualsBytes();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Scheduling of Server with a wakeup. The real AbstractMicrorlStreamSession
+ * needs Stm32Common and the firmware defines, so it is replaced by a stand-in
+ * with the members Server uses.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "Check.hpp"
+#include "Command/ClockInterface.hpp"
+#include "Readline/HostWakeup.hpp"
+#include "Readline/SessionSchedulerInterface.hpp"
+
+namespace Stm32Shell::Readline {
+    template<class T, size_t N>
+    class Server;
+
+    /** Host stand-in for the session base class, only what Server uses. */
+    class AbstractMicrorlStreamSession {
+    public:
+        template<class T, size_t N>
+        friend class Server;
+
+        virtual ~AbstractMicrorlStreamSession() = default;
+
+        virtual void setup() {
+        }
+
+        virtual void loop() {
+        }
+
+        virtual void end() {
+        }
+
+        void requestService() {
+            if (auto *s = scheduler.load(std::memory_order_acquire)) s->markReady(this);
+        }
+
+        virtual bool hasPendingWork() { return false; }
+
+        virtual uint32_t getTimeToDeadline(const uint32_t now) {
+            (void) now;
+            return UINT32_MAX;
+        }
+
+        static Command::ClockInterface *getClock();
+
+    private:
+        std::atomic<SessionSchedulerInterface *> scheduler{nullptr};
+    };
+}
+
+#include "Readline/Server.hpp"
+
+using Stm32Shell::Command::ClockInterface;
+using Stm32Shell::Command::Deadline;
+using Stm32Shell::Readline::AbstractMicrorlStreamSession;
+using Stm32Shell::Readline::HostWakeup;
+using Stm32Shell::Readline::Server;
+
+namespace {
+    /** Clock that only moves when the test says so. */
+    struct ManualClock : ClockInterface {
+        uint32_t now = 0xfffff000; // Close to the wrap
+
+        uint32_t micros() override { return now; }
+    };
+
+    ManualClock manualClock;
+
+    /** Counts its loop() calls, has pending work or a deadline on request. */
+    class StubSession : public AbstractMicrorlStreamSession {
+    public:
+        int loops = 0;
+        /** Number of loop() calls after which hasPendingWork() is still true. */
+        int pendingLoops = 0;
+        Deadline deadline;
+
+        void loop() override {
+            loops++;
+            if (pendingLoops > 0) pendingLoops--;
+            if (deadline.hasExpired(getClock()->micros())) deadline.clear();
+        }
+
+        bool hasPendingWork() override { return pendingLoops > 0; }
+
+        uint32_t getTimeToDeadline(const uint32_t now) override {
+            return deadline.isArmed() ? deadline.remaining(now) : UINT32_MAX;
+        }
+    };
+
+    using StubServer = Server<StubSession, 2>;
+
+    /** Opens a session and services its initial loop(). */
+    StubSession *openIdle(StubServer &server) {
+        auto *s = server.open();
+        server.loop();
+        s->loops = 0;
+        return s;
+    }
+
+    void testMarkReady() {
+        HostWakeup wakeup;
+        StubServer server;
+        server.setWakeup(&wakeup);
+        auto *s = openIdle(server);
+
+        CHECK(!server.waitForWork(1000));
+        server.loop();
+        CHECK(s->loops == 0);
+
+        s->requestService();
+        CHECK(server.waitForWork(1000));
+        server.loop();
+        CHECK(s->loops == 1);
+        CHECK(!server.waitForWork(1000));
+
+        // An event from another thread ends the wait
+        const auto start = std::chrono::steady_clock::now();
+        std::thread producer([s] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            s->requestService();
+        });
+        CHECK(server.waitForWork(10000000));
+        producer.join();
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        server.loop();
+        CHECK(s->loops == 2);
+    }
+
+    void testPendingWork() {
+        HostWakeup wakeup;
+        StubServer server;
+        server.setWakeup(&wakeup);
+        auto *s = openIdle(server);
+
+        s->pendingLoops = 3;
+        s->requestService();
+        for (int i = 1; i <= 3; i++) {
+            CHECK(server.waitForWork(1000));
+            server.loop();
+            CHECK(s->loops == i);
+        }
+        // No work left, the session is not scheduled anymore
+        CHECK(!server.waitForWork(1000));
+        server.loop();
+        CHECK(s->loops == 3);
+    }
+
+    void testDeadline() {
+        HostWakeup wakeup;
+        StubServer server;
+        server.setWakeup(&wakeup);
+        auto *s = openIdle(server);
+
+        // Not due yet: the wait ends at the deadline, not at the timeout
+        s->deadline.set(manualClock.now, 2000);
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(!server.waitForWork(10000000));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        server.loop();
+        CHECK(s->loops == 0);
+
+        // Expired, serviced without an event
+        manualClock.now += 2000;
+        CHECK(server.waitForWork(10000000));
+        server.loop();
+        CHECK(s->loops == 1);
+        CHECK(!s->deadline.isArmed());
+        CHECK(!server.waitForWork(1000));
+    }
+
+    void testIdleSkipped() {
+        HostWakeup wakeup;
+        StubServer server;
+        server.setWakeup(&wakeup);
+        auto *a = openIdle(server);
+        auto *b = openIdle(server);
+
+        b->requestService();
+        server.loop();
+        CHECK(a->loops == 0);
+        CHECK(b->loops == 1);
+
+        // Without a wakeup every open session is polled
+        server.setWakeup(nullptr);
+        CHECK(server.waitForWork(1000));
+        server.loop();
+        CHECK(a->loops == 1);
+        CHECK(b->loops == 2);
+
+        server.close(a);
+        server.setWakeup(&wakeup);
+        a->requestService();
+        CHECK(server.size() == 1);
+        CHECK(!server.waitForWork(1000));
+    }
+}
+
+ClockInterface *AbstractMicrorlStreamSession::getClock() {
+    return &manualClock;
+}
+
+int main() {
+    testMarkReady();
+    testPendingWork();
+    testDeadline();
+    testIdleSkipped();
+    return Stm32Shell::Test::result();
+}
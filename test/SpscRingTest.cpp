@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "Check.hpp"
+#include "Readline/SpscRing.hpp"
+
+using Stm32Shell::Readline::SpscRing;
+
+namespace {
+    void testWriteRead() {
+        SpscRing<8> ring;
+        CHECK(ring.getLength() == 0);
+        CHECK(ring.getRemainingSpace() == 8);
+
+        const uint8_t in[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        CHECK(ring.write(in, 5) == 5);
+        CHECK(ring.getLength() == 5);
+        // Only the free space is taken
+        CHECK(ring.write(in + 5, 5) == 3);
+        CHECK(ring.getRemainingSpace() == 0);
+
+        uint8_t out[10] = {};
+        CHECK(ring.read(out, sizeof out) == 8);
+        CHECK(std::memcmp(in, out, 8) == 0);
+        CHECK(ring.getLength() == 0);
+    }
+
+    void testWrapAround() {
+        SpscRing<8> ring;
+        const uint8_t in[] = {1, 2, 3, 4, 5, 6};
+        ring.write(in, 6);
+        ring.remove(6);
+
+        // Index 6 to 11, wraps after two bytes
+        ring.write(in, 6);
+        auto span = ring.peek();
+        CHECK(span.len == 2 && span.data[0] == 1 && span.data[1] == 2);
+        ring.remove(span.len);
+        span = ring.peek();
+        CHECK(span.len == 4 && span.data[0] == 3 && span.data[3] == 6);
+        ring.remove(span.len);
+        CHECK(ring.peek().len == 0);
+    }
+
+    void testClear() {
+        SpscRing<4> ring;
+        const uint8_t in[] = {1, 2, 3};
+        ring.write(in, 3);
+        ring.clear();
+        CHECK(ring.getLength() == 0);
+        CHECK(ring.getRemainingSpace() == 4);
+        static_assert(SpscRing<4>::capacity() == 4);
+    }
+
+    /**
+     * @brief Producer and consumer on separate threads.
+     *
+     * The producer writes a byte sequence in chunks of varying size, the
+     * consumer reads it back with peek()/remove() and read() alternately.
+     * Every byte must arrive exactly once and in order.
+     */
+    void testConcurrent() {
+        constexpr size_t total = 8 * 1024 * 1024;
+        SpscRing<64> ring;
+        std::atomic<bool> lengthError{false};
+
+        std::thread producer([&] {
+            uint8_t chunk[48];
+            size_t sent = 0;
+            uint32_t rnd = 1;
+            while (sent < total) {
+                rnd = rnd * 1103515245 + 12345;
+                size_t len = 1 + (rnd >> 16) % sizeof chunk;
+                if (len > total - sent) len = total - sent;
+                for (size_t i = 0; i < len; i++) chunk[i] = static_cast<uint8_t>((sent + i) * 7);
+                size_t done = 0;
+                while (done < len) {
+                    if (ring.getRemainingSpace() > ring.capacity()) lengthError = true;
+                    done += ring.write(chunk + done, len - done);
+                    if (done < len) std::this_thread::yield();
+                }
+                sent += len;
+            }
+        });
+
+        size_t received = 0;
+        size_t errors = 0;
+        uint8_t out[40];
+        bool usePeek = false;
+        while (received < total) {
+            if (ring.getLength() > ring.capacity()) lengthError = true;
+            usePeek = !usePeek;
+            if (usePeek) {
+                const auto span = ring.peek();
+                if (span.len == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < span.len; i++) {
+                    if (span.data[i] != static_cast<uint8_t>((received + i) * 7)) errors++;
+                }
+                ring.remove(span.len);
+                received += span.len;
+            } else {
+                const auto n = ring.read(out, sizeof out);
+                for (size_t i = 0; i < n; i++) {
+                    if (out[i] != static_cast<uint8_t>((received + i) * 7)) errors++;
+                }
+                received += n;
+            }
+        }
+        producer.join();
+
+        CHECK(received == total);
+        CHECK(errors == 0);
+        CHECK(!lengthError);
+        CHECK(ring.getLength() == 0);
+    }
+}
+
+int main() {
+    testWriteRead();
+    testWrapAround();
+    testClear();
+    testConcurrent();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <vector>
+#include "Check.hpp"
+#include "Readline/TelnetNegotiator.hpp"
+
+using Stm32Shell::Readline::TelnetNegotiator;
+using option = TelnetNegotiator::option;
+using side = TelnetNegotiator::side;
+
+namespace {
+    /** Negotiator that records everything it sends. */
+    struct Recorder {
+        TelnetNegotiator telnet;
+        std::vector<uint8_t> sent;
+
+        Recorder() {
+            telnet.registerOnSendFunction([this](const uint8_t *buf, const size_t len) {
+                sent.insert(sent.end(), buf, buf + len);
+            });
+        }
+
+        bool sentExactly(const std::vector<uint8_t> &expected) {
+            const bool ok = sent == expected;
+            sent.clear();
+            return ok;
+        }
+    };
+
+    constexpr uint8_t IAC = TelnetNegotiator::IAC;
+    constexpr uint8_t WILL = TelnetNegotiator::WILL;
+    constexpr uint8_t WONT = TelnetNegotiator::WONT;
+    constexpr uint8_t DO = TelnetNegotiator::DO;
+    constexpr uint8_t DONT = TelnetNegotiator::DONT;
+
+    void testBegin() {
+        Recorder r;
+        r.telnet.begin();
+        CHECK(r.sentExactly({
+            IAC, WILL, 1, IAC, WILL, 3, IAC, WILL, 0,
+            IAC, DO, 3, IAC, DO, 0, IAC, DO, 31
+            }));
+
+        // Agreement completes the request without another answer
+        r.telnet.receive(DO, 1);
+        r.telnet.receive(WILL, 31);
+        CHECK(r.sentExactly({}));
+        CHECK(r.telnet.isEnabled(option::ECHO, side::LOCAL));
+        CHECK(r.telnet.isEnabled(option::NAWS, side::REMOTE));
+
+        // Refusal disables it, also without an answer
+        r.telnet.receive(DONT, 0);
+        CHECK(r.sentExactly({}));
+        CHECK(!r.telnet.isEnabled(option::BINARY, side::LOCAL));
+    }
+
+    void testClientRequests() {
+        Recorder r;
+
+        // Unsupported option
+        r.telnet.receive(WILL, 24);
+        CHECK(r.sentExactly({IAC, DONT, 24}));
+
+        // Client echo would double the echo of the line editor
+        r.telnet.receive(WILL, 1);
+        CHECK(r.sentExactly({IAC, DONT, 1}));
+        CHECK(!r.telnet.isEnabled(option::ECHO, side::REMOTE));
+
+        r.telnet.receive(DO, 3);
+        CHECK(r.sentExactly({IAC, WILL, 3}));
+        CHECK(r.telnet.isEnabled(option::SGA, side::LOCAL));
+
+        // Repeated requests do not loop
+        r.telnet.receive(DO, 3);
+        CHECK(r.sentExactly({}));
+
+        r.telnet.receive(DONT, 3);
+        CHECK(r.sentExactly({IAC, WONT, 3}));
+        CHECK(!r.telnet.isEnabled(option::SGA, side::LOCAL));
+    }
+
+    void testQueuedRequest() {
+        Recorder r;
+        r.telnet.request(option::BINARY, side::LOCAL, true);
+        CHECK(r.sentExactly({IAC, WILL, 0}));
+
+        // Changed mind while the answer is pending, asked again after it
+        r.telnet.request(option::BINARY, side::LOCAL, false);
+        CHECK(r.sentExactly({}));
+        r.telnet.receive(DO, 0);
+        CHECK(r.sentExactly({IAC, WONT, 0}));
+        r.telnet.receive(DONT, 0);
+        CHECK(r.sentExactly({}));
+        CHECK(!r.telnet.isEnabled(option::BINARY, side::LOCAL));
+    }
+
+    void testWindowSize() {
+        Recorder r;
+        r.telnet.beginSubnegotiation();
+        for (const uint8_t ch: {31, 0, 132, 0, 43}) r.telnet.subnegotiationByte(ch);
+        CHECK(r.telnet.endSubnegotiation());
+        CHECK(r.telnet.getWidth() == 132);
+        CHECK(r.telnet.getHeight() == 43);
+
+        // Same size again is not reported
+        r.telnet.beginSubnegotiation();
+        for (const uint8_t ch: {31, 0, 132, 0, 43}) r.telnet.subnegotiationByte(ch);
+        CHECK(!r.telnet.endSubnegotiation());
+
+        // Overlong subnegotiations are ignored
+        r.telnet.beginSubnegotiation();
+        for (int i = 0; i < LIBSMART_STM32SHELL_TELNET_SB_LEN + 4; i++) r.telnet.subnegotiationByte(31);
+        CHECK(!r.telnet.endSubnegotiation());
+
+        r.telnet.reset();
+        CHECK(r.telnet.getWidth() == 0);
+    }
+}
+
+int main() {
+    testBegin();
+    testClientRequests();
+    testQueuedRequest();
+    testWindowSize();
+    return Stm32Shell::Test::result();
+}
@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_TEST_SUPPORT_NAMEABLE_HPP
+#define LIBSMART_STM32SHELL_TEST_SUPPORT_NAMEABLE_HPP
+
+namespace Stm32Common {
+    /**
+     * @brief Host stand-in for Stm32Common::Nameable, only what the shell uses.
+     */
+    class Nameable {
+    public:
+        Nameable() = default;
+
+        explicit Nameable(const char *name) : name(name) {
+        }
+
+        virtual ~Nameable() = default;
+
+        virtual const char *getName() const { return name; }
+
+        virtual void setName(const char *newName) { name = newName; }
+
+    private:
+        const char *name = nullptr;
+    };
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SHELL_TEST_SUPPORT_STRINGBUFFER_HPP
+#define LIBSMART_STM32SHELL_TEST_SUPPORT_STRINGBUFFER_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace Stm32Common {
+    /**
+     * @brief Host stand-in for Stm32Common::StringBuffer.
+     *
+     * Only the declarations needed to compile the command interfaces, the
+     * host tests do not write command output.
+     */
+    template<size_t N>
+    class StringBuffer {
+    public:
+        virtual ~StringBuffer() = default;
+
+        size_t getLength() const { return length; }
+
+        size_t getRemainingSpace() const { return N - length; }
+
+    protected:
+        virtual void onWrite() {
+        }
+
+    private:
+        size_t length = 0;
+    };
+}
+
+#endif
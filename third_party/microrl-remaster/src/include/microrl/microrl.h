@@ -96,18 +96,44 @@ struct microrl_hist_rbuf;
 #endif /* MICRORL_CFG_USE_HISTORY */
 
 #if MICRORL_CFG_USE_HISTORY || __DOXYGEN__
+#if MICRORL_CFG_RING_HISTORY_LEN > 65535
+#error "MICRORL_CFG_RING_HISTORY_LEN must fit into the 16 bit history index"
+#endif
+
 /**
  * \brief           History struct, contains internal variable
  *
- * History stores in static ring buffer for memory saving
+ * History stores in static ring buffer for memory saving.
+ * Records are stored back to back in `ring_buf` without separators, the
+ * start and length of each record is kept in an index ring, oldest first.
  *
  */
 typedef struct microrl_hist_rbuf {
     char ring_buf[MICRORL_CFG_RING_HISTORY_LEN];/*!< History buffer */
-    size_t head;                                /*!< Buffer head position */
-    size_t tail;                                /*!< Buffer tail position */
-    size_t count;                               /*!< Navigation counter */
+    uint16_t rec_off[MICRORL_CFG_HISTORY_MAX_RECORDS];  /*!< Start of each record in ring_buf */
+    uint16_t rec_len[MICRORL_CFG_HISTORY_MAX_RECORDS];  /*!< Length of each record */
+#if MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__
+    uint32_t rec_sig[MICRORL_CFG_HISTORY_MAX_RECORDS];  /*!< Bigram signature of each record */
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__ */
+    size_t rec_first;                           /*!< Index slot of the oldest record */
+    size_t rec_num;                             /*!< Number of records */
+    size_t used;                                /*!< Bytes of ring_buf used by records */
+    size_t count;                               /*!< Navigation counter, 0 is the current line, 1 the newest record */
+    uint32_t seq;                               /*!< Number of records saved since initialization */
 } microrl_hist_rbuf_t;
+
+#if MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__
+/**
+ * \brief           Reverse history search state
+ */
+typedef struct microrl_hist_search {
+    char str[MICRORL_CFG_HISTORY_SEARCH_LEN + 1];  /*!< Search string with NULL character */
+    size_t len;                                 /*!< Length of the search string */
+    uint32_t sig;                               /*!< Bigram signature of the search string */
+    size_t age;                                 /*!< Age of the current match, `0` if nothing matches */
+    uint8_t active;                             /*!< Search mode flag */
+} microrl_hist_search_t;
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__ */
 #endif /* MICRORL_CFG_USE_HISTORY || __DOXYGEN__ */
 
 /**
@@ -159,10 +185,17 @@ typedef struct microrl {
 #endif /* MICRORL_CFG_USE_CTRL_C || __DOXYGEN__ */
 
     char* prompt_ptr;                           /*!< Pointer to prompt string */
+    size_t prompt_len;                          /*!< Length of prompt string */
     char cmdline_str[MICRORL_CFG_CMDLINE_LEN + 1];  /*!< Command line input buffer with NULL character */
     size_t cmdlen;                              /*!< Command length in command line buffer */
     size_t cursor;                              /*!< Command line buffer position pointer */
     char last_endl;                             /*!< Either 0 or the CR or LF that just triggered a newline */
+    uint16_t term_width;                        /*!< Terminal width in columns, `0` if unknown */
+
+#if MICRORL_CFG_OUTPUT_BUFFER_LEN > 0 || __DOXYGEN__
+    char out_buf[MICRORL_CFG_OUTPUT_BUFFER_LEN + 1];    /*!< Output buffer with NULL character */
+    size_t out_len;                             /*!< Number of characters in the output buffer */
+#endif /* MICRORL_CFG_OUTPUT_BUFFER_LEN > 0 || __DOXYGEN__ */
 
 #if MICRORL_CFG_USE_ESC_SEQ || __DOXYGEN__
     microrl_esc_code_t esc_code;                /*!< Code of first escape sequence symbol */
@@ -173,6 +206,10 @@ typedef struct microrl {
     microrl_hist_rbuf_t ring_hist;              /*!< Ring history object */
 #endif /* MICRORL_CFG_USE_HISTORY || __DOXYGEN__ */
 
+#if MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__
+    microrl_hist_search_t hist_search;          /*!< Reverse history search object */
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__ */
+
 #if MICRORL_CFG_USE_ECHO_OFF || __DOXYGEN__
     microrl_echo_t echo;                        /*!< Echo mode */
     int32_t echo_off_pos;                       /*!< Start position to print '*' echo off chars */
@@ -192,12 +229,20 @@ microrlr_t  microrl_set_sigint_callback(microrl_t* mrl, microrl_sigint_fn sigint
 #endif /* MICRORL_CFG_USE_CTRL_C */
 
 microrlr_t  microrl_set_prompt(microrl_t* mrl, char* prompt_str);
+microrlr_t  microrl_set_term_width(microrl_t* mrl, uint16_t width);
 #if MICRORL_CFG_USE_ECHO_OFF || __DOXYGEN__
 microrlr_t  microrl_set_echo(microrl_t* mrl, microrl_echo_t echo);
 #endif /* #if MICRORL_CFG_USE_ECHO_OFF */
 
 microrlr_t  microrl_processing_input(microrl_t* mrl, const void* data_ptr, size_t len);
 
+#if MICRORL_CFG_USE_HISTORY || __DOXYGEN__
+microrlr_t  microrl_hist_add(microrl_t* mrl, const char* line_str, size_t len);
+size_t      microrl_hist_get(const microrl_t* mrl, size_t age, char* buf, size_t size);
+size_t      microrl_hist_records(const microrl_t* mrl);
+uint32_t    microrl_hist_seq(const microrl_t* mrl);
+#endif /* MICRORL_CFG_USE_HISTORY || __DOXYGEN__ */
+
 uint32_t    microrl_get_version(void);
 
 /**
@@ -62,6 +62,8 @@ extern "C" {
  *                  about this, the command line will not be parsed and the 'execute' callback will not be called.
  *                  Token is a word, that separate by whitespace, for example, line with 3 tokens:
  *                  "> set mode test"
+ *                  The line is not modified by tokenizing, each token costs a 4 byte view and an
+ *                  argument pointer on the stack while the line is executed or completed
  */
 #ifndef MICRORL_CFG_CMD_TOKEN_NMB
 #define MICRORL_CFG_CMD_TOKEN_NMB             8
@@ -114,6 +116,25 @@ extern "C" {
 #define MICRORL_CFG_USE_QUOTING               0
 #endif
 
+/**
+ * \brief           Enable it, if you want to execute several commands from one line.
+ *                  Commands are separated by \ref MICRORL_CFG_COMMAND_SEPARATOR and executed one after
+ *                  another, the line is stored in the history once. With \ref MICRORL_CFG_USE_QUOTING
+ *                  a quoted or escaped separator is part of the token, for example, 3 commands:
+ *                  "> led on; delay 100; led off"
+ */
+#ifndef MICRORL_CFG_USE_COMMAND_SEPARATOR
+#define MICRORL_CFG_USE_COMMAND_SEPARATOR     0
+#endif
+
+/**
+ * \brief           Character separating commands on one line
+ *                      Not used if \ref MICRORL_CFG_USE_COMMAND_SEPARATOR is set to 0
+ */
+#ifndef MICRORL_CFG_COMMAND_SEPARATOR
+#define MICRORL_CFG_COMMAND_SEPARATOR         ';'
+#endif
+
 /**
  * \brief           Enable it, if you want to use "echo off" feature.
  *                  "Echo off" is used for typing the secret input data, like passwords.
@@ -151,12 +172,51 @@ extern "C" {
  *                  To save memory, each command typed is stored in history ring buffer.
  *                  So we can not say, how many line we can store, it depends from command line length,
  *                  but memory using more effective. We not prefer dinamic memory allocation for small and
- *                  embedded devices. Overhead is 1 char on each saved record (command + terminating zero)
+ *                  embedded devices. Records are stored without terminating zero, see
+ *                  MICRORL_CFG_HISTORY_MAX_RECORDS for the overhead of the record index
  */
 #ifndef MICRORL_CFG_RING_HISTORY_LEN
 #define MICRORL_CFG_RING_HISTORY_LEN          64
 #endif
 
+/**
+ * \brief           Maximum number of records in the history.
+ *                  The offset and length of every record is kept in a small index,
+ *                  so navigation does not have to walk through the ring buffer.
+ *                  Costs 4 bytes per record. When the index is full, the oldest
+ *                  record is dropped, even if there is space left in the ring buffer
+ */
+#ifndef MICRORL_CFG_HISTORY_MAX_RECORDS
+#define MICRORL_CFG_HISTORY_MAX_RECORDS       16
+#endif
+
+/**
+ * \brief           Size of the output buffer. Terminal output is collected in this buffer
+ *                  and passed to the output callback once per call of 'microrl_processing_input()',
+ *                  instead of one callback per echoed character or escape sequence.
+ *                  Set to 0 to pass every string to the output callback immediately
+ */
+#ifndef MICRORL_CFG_OUTPUT_BUFFER_LEN
+#define MICRORL_CFG_OUTPUT_BUFFER_LEN         128
+#endif
+
+/**
+ * \brief           Enable it, if you want to use incremental reverse history search (Ctrl+R).
+ *                  Works like bash reverse-i-search. Each record gets a 32 bit bigram signature,
+ *                  so records which can not contain the search string are skipped without
+ *                  comparing them. Needs \ref MICRORL_CFG_USE_HISTORY
+ */
+#ifndef MICRORL_CFG_USE_HISTORY_SEARCH
+#define MICRORL_CFG_USE_HISTORY_SEARCH        MICRORL_CFG_USE_HISTORY
+#endif
+
+/**
+ * \brief           Maximum length of the reverse history search string
+ */
+#ifndef MICRORL_CFG_HISTORY_SEARCH_LEN
+#define MICRORL_CFG_HISTORY_SEARCH_LEN        16
+#endif
+
 /**
  * \brief           Size of the buffer used for piecemeal printing of part or all of the command
  *                  line buffer. Allocated on the stack. Must be at least 16.
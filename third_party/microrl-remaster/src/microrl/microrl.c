@@ -93,78 +93,195 @@ typedef enum {
     MICRORL_HIST_DIR_DOWN                           /*!< Next record in history ring buffer */
 } microrl_hist_dir_t;
 
+#if MICRORL_CFG_OUTPUT_BUFFER_LEN > 0 || __DOXYGEN__
 /**
- * \brief           Split command line to tokens array
+ * \brief           Pass buffered output to the output callback
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ */
+static void prv_output_flush(microrl_t* mrl) {
+    if (mrl->out_len > 0) {
+        mrl->out_buf[mrl->out_len] = '\0';
+        mrl->out_len = 0;
+        mrl->out_fn(mrl, mrl->out_buf);
+    }
+}
+
+/**
+ * \brief           Print string in terminal.
+ *                      Output is collected in the output buffer and passed to the output callback
+ *                      when the buffer is full, before a user callback is called and when all input
+ *                      is processed, so the transport is notified only once per input chunk
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       str: String to print
+ */
+static void prv_output(microrl_t* mrl, const char* str) {
+    size_t len = strlen(str);
+
+    if (mrl->out_len + len > MICRORL_CFG_OUTPUT_BUFFER_LEN) {
+        prv_output_flush(mrl);
+        if (len > MICRORL_CFG_OUTPUT_BUFFER_LEN) {
+            mrl->out_fn(mrl, str);              /* Too long for the buffer anyway */
+            return;
+        }
+    }
+    memcpy(&mrl->out_buf[mrl->out_len], str, len);
+    mrl->out_len += len;
+}
+#else
+#define prv_output_flush(mrl)
+#define prv_output(mrl, str)                (mrl)->out_fn((mrl), (str))
+#endif /* MICRORL_CFG_OUTPUT_BUFFER_LEN > 0 || __DOXYGEN__ */
+
+/**
+ * \brief           Token view, position of a token in the command line.
+ *                      Quotes and escape characters are part of the view
+ */
+typedef struct {
+    uint16_t off;                                   /*!< Offset of the first character */
+    uint16_t len;                                   /*!< Number of characters */
+} microrl_token_t;
+
+#if MICRORL_CFG_CMDLINE_LEN > 65535
+#error "MICRORL_CFG_CMDLINE_LEN must fit into the 16 bit token view"
+#endif
+
+#if MICRORL_CFG_USE_QUOTING || __DOXYGEN__
+/**
+ * \brief           Check if a character can be escaped with a backslash
+ * \param[in]       ch: Character following the backslash
+ * \return          `1` if backslash and character are an escape sequence, `0` otherwise
+ */
+MICRORL_CFG_STATIC_INLINE uint8_t prv_is_escapable(char ch) {
+    return ch == '"' || ch == '\'' || ch == '\\' || ch == ' '
+#if MICRORL_CFG_USE_COMMAND_SEPARATOR
+           || ch == MICRORL_CFG_COMMAND_SEPARATOR
+#endif /* MICRORL_CFG_USE_COMMAND_SEPARATOR */
+        ;
+}
+#endif /* MICRORL_CFG_USE_QUOTING || __DOXYGEN__ */
+
+/**
+ * \brief           Check if a character ends a command
+ * \param[in]       ch: Character to check
+ * \return          `1` if the character is the command separator, `0` otherwise
+ */
+MICRORL_CFG_STATIC_INLINE uint8_t prv_is_separator(char ch) {
+#if MICRORL_CFG_USE_COMMAND_SEPARATOR
+    return ch == MICRORL_CFG_COMMAND_SEPARATOR;
+#else
+    (void)ch;
+    return 0;
+#endif /* MICRORL_CFG_USE_COMMAND_SEPARATOR */
+}
+
+/**
+ * \brief           Find the tokens of one command in the command line without modifying it.
+ *                      Tokens are separated by whitespace. With \ref MICRORL_CFG_USE_QUOTING
+ *                      whitespace inside single or double quotes and whitespace escaped
+ *                      with backslash do not separate tokens. With \ref MICRORL_CFG_USE_COMMAND_SEPARATOR
+ *                      the command ends at the first unquoted separator
  * \param[in]       mrl: \ref microrl_t working instance
- * \param[out]      tkn_str_arr: Tokens buffer stored split words
- * \param[out]      tkn_cnt_ptr: Number of split tokens
- * \param[in]       limit: Number of command line characters to split
+ * \param[in,out]   pos_ptr: Position to start at. Set to the separator ending the command, or to `limit`
+ * \param[in]       limit: Number of command line characters to tokenize
+ * \param[out]      tkn_arr: Token views, \ref MICRORL_CFG_CMD_TOKEN_NMB entries
+ * \param[out]      tkn_cnt_ptr: Number of tokens
+ * \param[out]      quote_ptr: Quote character which is still open at `limit`, `0` if none. May be NULL
  * \return          \ref microrlOK on success, member of \ref microrlr_t enumeration otherwise
  */
-static microrlr_t prv_cmdline_buf_split(microrl_t* mrl, const char** tkn_str_arr, uint8_t* tkn_cnt_ptr, size_t limit) {
-    uint8_t num = 0;
-    char *str = mrl->cmdline_str;
+static microrlr_t prv_cmdline_tokenize(const microrl_t* mrl, size_t* pos_ptr, size_t limit, microrl_token_t* tkn_arr,
+                                       size_t* tkn_cnt_ptr, char* quote_ptr) {
+    const char* str = mrl->cmdline_str;
+    size_t num = 0;
+    size_t i = *pos_ptr;
+
+    *tkn_cnt_ptr = 0;
+    if (quote_ptr != NULL) {
+        *quote_ptr = 0;
+    }
+    while (i < limit) {
+        while (i < limit && str[i] == ' ') {    /* Skip whitespace between tokens */
+            ++i;
+        }
+        if (i == limit || prv_is_separator(str[i])) {
+            break;
+        }
+        if (num == MICRORL_CFG_CMD_TOKEN_NMB) { /* Check for number of tokens */
+            return microrlERRTKNNUM;
+        }
 
-    /* Process complete string */
-    while (*str != '\0') {
+        size_t start = i;
 #if MICRORL_CFG_USE_QUOTING
-        if (*str == '"' || *str == '\'') {      /* Check if it starts with quote to handle escapes */
-            ++str;
-            tkn_str_arr[num++] = str;           /* Set start of argument after quotes */
-
-            while (*str != '\0') {              /* Process until end of quote */
-                if (!((size_t)(str - mrl->cmdline_str) < limit)) {
-                    tkn_str_arr[--num] = NULL;
-                    *tkn_cnt_ptr = num;
-                    return microrlOK;
-                }
-
-                if (*str == '\\') {
-                    ++str;
-                    if (*str == '"' || *str == '\'') {
-                        ++str;
-                    }
-                } else if (*str == '"' || *str == '\'') {
-                    *str = '\0';
-                    ++str;
-                    break;
-                } else {
-                    ++str;
-                }
-            }
-        } else {
-#endif /* MICRORL_CFG_USE_QUOTING */
-            tkn_str_arr[num++] = str;           /* Set start of argument directly on character */
-            while ((*str != ' ' && *str != '\0')) {
-                if (!((size_t)(str - mrl->cmdline_str) < limit)) {
-                    tkn_str_arr[--num] = NULL;
-                    *tkn_cnt_ptr = num;
-                    return microrlOK;
-                }
-#if MICRORL_CFG_USE_QUOTING
-                if (*str == '"' || *str == '\'') {   /* Quote should not be here... */
-                    *str = '\0';                /* ...add NULL termination to end token */
-                }
-#endif /* MICRORL_CFG_USE_QUOTING */
-                ++str;
+        char quote = 0;
+        while (i < limit && (quote != 0 || (str[i] != ' ' && !prv_is_separator(str[i])))) {
+            if (str[i] == '\\' && (i + 1) < limit && prv_is_escapable(str[i + 1])) {
+                i += 2;
+                continue;
             }
-            if (*str == '\0') {
-                break;
+            if (quote == 0 && (str[i] == '"' || str[i] == '\'')) {
+                quote = str[i];
+            } else if (str[i] == quote) {
+                quote = 0;
             }
-            *str = '\0';
-            ++str;
-#if MICRORL_CFG_USE_QUOTING
+            ++i;
         }
-#endif /* MICRORL_CFG_USE_QUOTING */
-        if (num == MICRORL_CFG_CMD_TOKEN_NMB && *str != '\0') {     /* Check for number of tokens */
-            return microrlERRTKNNUM;
+        if (quote_ptr != NULL) {
+            *quote_ptr = quote;
+        }
+#else
+        while (i < limit && str[i] != ' ' && !prv_is_separator(str[i])) {
+            ++i;
         }
+#endif /* MICRORL_CFG_USE_QUOTING */
+
+        tkn_arr[num].off = (uint16_t)start;
+        tkn_arr[num].len = (uint16_t)(i - start);
+        ++num;
     }
 
+    *pos_ptr = i;
     *tkn_cnt_ptr = num;
     return microrlOK;
 }
 
+/**
+ * \brief           Copy tokens to a buffer as NULL terminated arguments.
+ *                      Quotes are removed and escape sequences are replaced
+ *                      by the escaped character
+ * \param[in]       mrl: \ref microrl_t working instance
+ * \param[in]       tkn_arr: Token views returned by \ref prv_cmdline_tokenize
+ * \param[in]       tkn_cnt: Number of tokens
+ * \param[out]      buf: Buffer for the arguments, at least \ref MICRORL_CFG_CMDLINE_LEN + 1 bytes
+ * \param[out]      argv: Argument pointers, at least `tkn_cnt + 1` entries, NULL terminated
+ */
+static void prv_cmdline_tokens_to_args(const microrl_t* mrl, const microrl_token_t* tkn_arr, size_t tkn_cnt,
+                                       char* buf, const char** argv) {
+    for (size_t t = 0; t < tkn_cnt; ++t) {
+        const char* src = &mrl->cmdline_str[tkn_arr[t].off];
+        size_t len = tkn_arr[t].len;
+
+        argv[t] = buf;
+#if MICRORL_CFG_USE_QUOTING
+        char quote = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (src[i] == '\\' && (i + 1) < len && prv_is_escapable(src[i + 1])) {
+                *buf++ = src[++i];
+            } else if (quote == 0 && (src[i] == '"' || src[i] == '\'')) {
+                quote = src[i];
+            } else if (src[i] == quote) {
+                quote = 0;
+            } else {
+                *buf++ = src[i];
+            }
+        }
+#else
+        memcpy(buf, src, len);
+        buf += len;
+#endif /* MICRORL_CFG_USE_QUOTING */
+        *buf++ = '\0';
+    }
+    argv[tkn_cnt] = NULL;
+}
+
 /**
  * \brief           Insert the passed text at the cursor position
  * \param[in,out]   mrl: \ref microrl_t working instance
@@ -190,7 +307,7 @@ static microrlr_t prv_cmdline_buf_insert_text(microrl_t* mrl, const char* text_s
     }
     mrl->cursor += len;
     mrl->cmdlen += len;
-    memset(&mrl->cmdline_str[mrl->cmdlen], 0x00, MICRORL_ARRAYSIZE(mrl->cmdline_str) - 1 - mrl->cmdlen);
+    mrl->cmdline_str[mrl->cmdlen] = '\0';
 
     return microrlOK;
 }
@@ -207,9 +324,8 @@ static void prv_cmdline_buf_backspace(microrl_t* mrl, size_t len) {
 
     memmove(mrl->cmdline_str + mrl->cursor - len,
             mrl->cmdline_str + mrl->cursor,
-            mrl->cmdlen - mrl->cursor + len);
+            mrl->cmdlen - mrl->cursor + 1);     /* Including NULL character */
     mrl->cursor -= len;
-    mrl->cmdline_str[mrl->cmdlen] = '\0';
     mrl->cmdlen -= len;
 }
 
@@ -224,8 +340,7 @@ static void prv_cmdline_buf_delete(microrl_t* mrl) {
 
     memmove(mrl->cmdline_str + mrl->cursor,
             mrl->cmdline_str + mrl->cursor + 1,
-            mrl->cmdlen - mrl->cursor + 1);
-    mrl->cmdline_str[mrl->cmdlen] = '\0';
+            mrl->cmdlen - mrl->cursor);         /* Including NULL character */
     --mrl->cmdlen;
 }
 
@@ -245,11 +360,11 @@ MICRORL_CFG_STATIC_INLINE void prv_cmdline_buf_reset(microrl_t* mrl) {
  */
 MICRORL_CFG_STATIC_INLINE void prv_terminal_print_prompt(microrl_t* mrl) {
 #if MICRORL_CFG_USE_PROMPT_COLOR
-    mrl->out_fn(mrl, MICRORL_CFG_PROMPT_COLOR);
-    mrl->out_fn(mrl, mrl->prompt_ptr);
-    mrl->out_fn(mrl, MICRORL_COLOR_DEFAULT);
+    prv_output(mrl, MICRORL_CFG_PROMPT_COLOR);
+    prv_output(mrl, mrl->prompt_ptr);
+    prv_output(mrl, MICRORL_COLOR_DEFAULT);
 #else
-    mrl->out_fn(mrl, mrl->prompt_ptr);
+    prv_output(mrl, mrl->prompt_ptr);
 #endif
 }
 
@@ -259,7 +374,7 @@ MICRORL_CFG_STATIC_INLINE void prv_terminal_print_prompt(microrl_t* mrl) {
  * \param[in]       mrl: \ref microrl_t working instance
  */
 MICRORL_CFG_STATIC_INLINE void prv_terminal_backspace(microrl_t* mrl) {
-    mrl->out_fn(mrl, "\033[D \033[D");
+    prv_output(mrl, "\033[D \033[D");
 }
 
 /**
@@ -267,14 +382,14 @@ MICRORL_CFG_STATIC_INLINE void prv_terminal_backspace(microrl_t* mrl) {
  * \param[in]       mrl: \ref microrl_t working instance
  */
 MICRORL_CFG_STATIC_INLINE void prv_terminal_newline(microrl_t* mrl) {
-    mrl->out_fn(mrl, MICRORL_CFG_END_LINE);
+    prv_output(mrl, MICRORL_CFG_END_LINE);
 }
 
 /**
  * \brief           Insert ESC sequence into the passed string to set the cursor
  *                      at the current position + offset (positive or negative)
  *                      in in the terminal command line.
- *                      The passed string must be at least 7 bytes long
+ *                      The passed string must be at least 8 bytes long
  * \param[in]       str: The original string before moving the cursor
  * \param[in]       offset: Positive or negative interval to move cursor
  * \return          The original string after moving the cursor
@@ -282,11 +397,11 @@ MICRORL_CFG_STATIC_INLINE void prv_terminal_newline(microrl_t* mrl) {
 static char* prv_cursor_generate_move(char* str, int32_t offset) {
     char c = 'C';
 
-    if (offset > 999) {
-        offset = 999;
+    if (offset > 9999) {
+        offset = 9999;
     }
-    if (offset < -999) {
-        offset = -999;
+    if (offset < -9999) {
+        offset = -9999;
     }
     if (offset < 0) {
         offset = -offset;
@@ -302,7 +417,7 @@ static char* prv_cursor_generate_move(char* str, int32_t offset) {
     *str++ = '\033';
     *str++ = '[';
 
-    char tmp_str[4] = {0};
+    char tmp_str[5] = {0};
     size_t i = 0;
 
     while (offset > 0) {
@@ -334,7 +449,7 @@ static void prv_terminal_move_cursor(microrl_t* mrl, int32_t offset) {
 
     char str[16] = {0};
     prv_cursor_generate_move(str, offset);
-    mrl->out_fn(mrl, str);
+    prv_output(mrl, str);
 }
 
 /**
@@ -350,10 +465,10 @@ static void prv_terminal_print_line(microrl_t* mrl, int32_t pos, uint8_t reset)
     if (reset) {
 #if MICRORL_CFG_USE_CARRIAGE_RETURN
         *str_ptr++ = '\r';
-        str_ptr = prv_cursor_generate_move(str_ptr, strlen(mrl->prompt_ptr) + pos);
+        str_ptr = prv_cursor_generate_move(str_ptr, mrl->prompt_len + pos);
 #else
-        str_ptr = prv_cursor_generate_move(str_ptr, -(MICRORL_ARRAYSIZE(mrl->cmdline_str) - 1 + strlen(mrl->prompt_ptr) + 2));
-        str_ptr = prv_cursor_generate_move(str_ptr, strlen(mrl->prompt_ptr) + pos);
+        str_ptr = prv_cursor_generate_move(str_ptr, -(MICRORL_ARRAYSIZE(mrl->cmdline_str) - 1 + mrl->prompt_len + 2));
+        str_ptr = prv_cursor_generate_move(str_ptr, mrl->prompt_len + pos);
 #endif /* MICRORL_CFG_USE_CARRIAGE_RETURN */
     }
 
@@ -368,16 +483,16 @@ static void prv_terminal_print_line(microrl_t* mrl, int32_t pos, uint8_t reset)
 
         ++str_ptr;
 
-        if ((size_t)(str_ptr - str) == strlen(str)) {
+        if ((size_t)(str_ptr - str) == MICRORL_ARRAYSIZE(str) - 1) {
             *str_ptr = '\0';
-            mrl->out_fn(mrl, str);
+            prv_output(mrl, str);
             str_ptr = str;
         }
     }
 
-    if ((size_t)(str_ptr - str + 3 + 6 + 1) > MICRORL_ARRAYSIZE(str)) {
+    if ((size_t)(str_ptr - str + 3 + 7 + 1) > MICRORL_ARRAYSIZE(str)) {
         *str_ptr = '\0';
-        mrl->out_fn(mrl, str);
+        prv_output(mrl, str);
         str_ptr = str;
     }
 
@@ -385,25 +500,84 @@ static void prv_terminal_print_line(microrl_t* mrl, int32_t pos, uint8_t reset)
     *str_ptr++ = '[';
     *str_ptr++ = 'K';
     prv_cursor_generate_move(str_ptr, mrl->cursor - mrl->cmdlen);
-    mrl->out_fn(mrl, str);
+    prv_output(mrl, str);
 }
 
 #if MICRORL_CFG_USE_HISTORY || __DOXYGEN__
 
+#if MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__
+/**
+ * \brief           Calculate the bigram signature of a string.
+ *                      Every pair of adjacent characters sets one of 32 bits, a string can only
+ *                      contain another one if all bits of the other signature are set
+ * \param[in]       str: String
+ * \param[in]       len: Length of the string
+ * \return          Signature of the string
+ */
+static uint32_t prv_hist_sig(const char* str, size_t len) {
+    uint32_t sig = 0;
+
+    for (size_t i = 1; i < len; ++i) {
+        sig |= (uint32_t)1 << ((((uint8_t)str[i - 1] * 7U) ^ (uint8_t)str[i]) & 0x1FU);
+    }
+
+    return sig;
+}
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__ */
+
 /**
- * \brief           Set the next record start position to the passed index
+ * \brief           Get index slot of a record
  * \param[in]       rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
- * \param[in,out]   idx_ptr: Pointer to the current record
+ * \param[in]       age: Age of the record, `1` is the newest record
+ * \return          Index slot in `rec_off` and `rec_len`
  */
-MICRORL_CFG_STATIC_INLINE void prv_hist_next_record(microrl_hist_rbuf_t* rbuf_ptr, size_t* idx_ptr) {
-    while (rbuf_ptr->ring_buf[++(*idx_ptr)] != '\0') {
-        if (*idx_ptr >= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
-            *idx_ptr -= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf);
-            if (rbuf_ptr->ring_buf[*idx_ptr] == '\0') {
-                break;
-            }
-        }
+MICRORL_CFG_STATIC_INLINE size_t prv_hist_slot(const microrl_hist_rbuf_t* rbuf_ptr, size_t age) {
+    return (rbuf_ptr->rec_first + rbuf_ptr->rec_num - age) % MICRORL_CFG_HISTORY_MAX_RECORDS;
+}
+
+/**
+ * \brief           Copy a record out of the ring buffer
+ * \param[in]       rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
+ * \param[in]       slot: Index slot of the record
+ * \param[out]      line_str: Buffer for the record, at least \ref MICRORL_CFG_CMDLINE_LEN bytes
+ * \return          Length of the record
+ */
+static size_t prv_hist_copy_record(const microrl_hist_rbuf_t* rbuf_ptr, size_t slot, char* line_str) {
+    size_t off = rbuf_ptr->rec_off[slot];
+    size_t len = rbuf_ptr->rec_len[slot];
+
+    if ((off + len) <= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
+        memcpy(line_str, rbuf_ptr->ring_buf + off, len);
+    } else {
+        size_t part0 = MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - off;
+        memcpy(line_str, rbuf_ptr->ring_buf + off, part0);
+        memcpy(line_str + part0, rbuf_ptr->ring_buf, len - part0);
+    }
+
+    return len;
+}
+
+/**
+ * \brief           Compare a record with a line
+ * \param[in]       rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
+ * \param[in]       slot: Index slot of the record
+ * \param[in]       line_str: Line to compare
+ * \param[in]       len: Length of the line
+ * \return          `1` if the record equals the line, `0` otherwise
+ */
+static uint8_t prv_hist_record_equals(const microrl_hist_rbuf_t* rbuf_ptr, size_t slot, const char* line_str, size_t len) {
+    size_t off = rbuf_ptr->rec_off[slot];
+
+    if (rbuf_ptr->rec_len[slot] != len) {
+        return 0;
+    }
+    if ((off + len) <= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
+        return memcmp(rbuf_ptr->ring_buf + off, line_str, len) == 0;
     }
+
+    size_t part0 = MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - off;
+    return memcmp(rbuf_ptr->ring_buf + off, line_str, part0) == 0
+           && memcmp(rbuf_ptr->ring_buf, line_str + part0, len - part0) == 0;
 }
 
 /**
@@ -411,9 +585,9 @@ MICRORL_CFG_STATIC_INLINE void prv_hist_next_record(microrl_hist_rbuf_t* rbuf_pt
  * \param[in,out]   rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
  */
 static void prv_hist_erase_older(microrl_hist_rbuf_t* rbuf_ptr) {
-    size_t new_pos = rbuf_ptr->head;
-    prv_hist_next_record(rbuf_ptr, &new_pos);
-    rbuf_ptr->head = new_pos;
+    rbuf_ptr->used -= rbuf_ptr->rec_len[rbuf_ptr->rec_first];
+    rbuf_ptr->rec_first = (rbuf_ptr->rec_first + 1) % MICRORL_CFG_HISTORY_MAX_RECORDS;
+    --rbuf_ptr->rec_num;
 }
 
 /**
@@ -422,51 +596,52 @@ static void prv_hist_erase_older(microrl_hist_rbuf_t* rbuf_ptr) {
  * \param[in]       len: Length of new record to save in history
  * \return          Member of \ref microrl_hist_status_t enumeration
  */
-static microrl_hist_status_t prv_hist_is_space_for_new(microrl_hist_rbuf_t* rbuf_ptr, size_t len) {
-    if (rbuf_ptr->tail >= rbuf_ptr->head) {
-        if ((MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - rbuf_ptr->tail + rbuf_ptr->head - 1) > len) {
-            return MICRORL_HIST_NOT_FULL;
-        }
-    } else {
-        if ((rbuf_ptr->head - rbuf_ptr->tail - 1) > len) {
-            return MICRORL_HIST_NOT_FULL;
-        }
+MICRORL_CFG_STATIC_INLINE microrl_hist_status_t prv_hist_is_space_for_new(microrl_hist_rbuf_t* rbuf_ptr, size_t len) {
+    if ((rbuf_ptr->rec_num < MICRORL_CFG_HISTORY_MAX_RECORDS)
+        && ((MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - rbuf_ptr->used) >= len)) {
+        return MICRORL_HIST_NOT_FULL;
     }
 
     return MICRORL_HIST_FULL;
 }
 
 /**
- * \brief           Copy saved record to 'line_str' and return size of record
+ * \brief           Get length of the common prefix of a record and a string
  * \param[in]       rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
- * \param[out]      line_str: Line to restore from history
- * \param[in]       dir: Record search direction, member of \ref microrl_hist_dir_t
- * \return          Size of restored line. `0` is returned, if history is empty
+ * \param[in]       slot: Index slot of the record
+ * \param[in]       str: String to compare
+ * \param[in]       len: Length of the string
+ * \return          Number of equal characters at the start
  */
-static size_t prv_hist_restore_line(microrl_hist_rbuf_t* rbuf_ptr, char* line_str, microrl_hist_dir_t dir) {
-    size_t cnt = 0;
-    size_t i = rbuf_ptr->head;
-    while (i != rbuf_ptr->tail) {               /* Count history records */
-        prv_hist_next_record(rbuf_ptr, &i);
-        ++cnt;
+static size_t prv_hist_record_prefix(const microrl_hist_rbuf_t* rbuf_ptr, size_t slot, const char* str, size_t len) {
+    size_t off = rbuf_ptr->rec_off[slot];
+    size_t n = rbuf_ptr->rec_len[slot] < len ? rbuf_ptr->rec_len[slot] : len;
+    size_t i = 0;
+
+    while (i < n && rbuf_ptr->ring_buf[(off + i) % MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)] == str[i]) {
+        ++i;
     }
 
+    return i;
+}
+
+/**
+ * \brief           Move the navigation counter
+ * \param[in,out]   rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
+ * \param[in]       dir: Record search direction, member of \ref microrl_hist_dir_t
+ * \return          Age of the record to restore. `0` for an empty line
+ */
+static size_t prv_hist_navigate(microrl_hist_rbuf_t* rbuf_ptr, microrl_hist_dir_t dir) {
     switch (dir) {
         case MICRORL_HIST_DIR_UP: {             /* Set navigation counter depending on the direction */
-            if (cnt < rbuf_ptr->count) {
-                return 0;                       /* Impossible state, return empty line */
-            }
-            if (cnt != rbuf_ptr->count) {
+            if (rbuf_ptr->count < rbuf_ptr->rec_num) {
                 ++rbuf_ptr->count;
             }
             break;
         }
         case MICRORL_HIST_DIR_DOWN: {
-            if (rbuf_ptr->count == 0) {
-                return 0;                       /* Empty line */
-            }
-            if (--rbuf_ptr->count == 0) {
-                return 0;                       /* Empty line */
+            if (rbuf_ptr->count > 0) {
+                --rbuf_ptr->count;
             }
             break;
         }
@@ -474,37 +649,16 @@ static size_t prv_hist_restore_line(microrl_hist_rbuf_t* rbuf_ptr, char* line_st
             break;
     }
 
-    size_t idx = rbuf_ptr->head;
-    size_t j = 0;
-    while ((cnt - j++) != rbuf_ptr->count) {    /* Find record for 'rbuf_ptr->count' counter */
-        prv_hist_next_record(rbuf_ptr, &idx);
-    }
-
-    ++idx;                                      /* Move position from `\0` marker */
-
-    size_t rec_len = 0;
-    size_t k = idx;
-    while (rbuf_ptr->ring_buf[k++] != '\0') {   /* Calculating the length of the found record */
-        if (k >= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
-            k -= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf);
-        }
-        ++rec_len;
-    }
-
-    memset(line_str, 0x00, MICRORL_CFG_CMDLINE_LEN);    /* Placing the found record on the command line */
-    if ((idx + rec_len) < MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
-        memcpy(line_str, rbuf_ptr->ring_buf + idx, rec_len);
-    } else {
-        size_t part0 = MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - idx;
-        memcpy(line_str, rbuf_ptr->ring_buf + idx, part0);
-        memcpy(line_str + part0, rbuf_ptr->ring_buf, rec_len - part0);
+    if (rbuf_ptr->count > rbuf_ptr->rec_num) {
+        return 0;
     }
 
-    return rec_len;
+    return rbuf_ptr->count;
 }
 
 /**
- * \brief           Restore record to command line from history buffer
+ * \brief           Restore record to command line from history buffer.
+ *                      Only the part of the line that differs from the current line is redrawn
  * \param[in,out]   mrl: \ref microrl_t working instance
  * \param[in]       dir: Member of \ref microrl_hist_dir_t enumeration
  */
@@ -515,10 +669,20 @@ static void prv_hist_search(microrl_t* mrl, microrl_hist_dir_t dir) {
     }
 #endif /* MICRORL_CFG_USE_ECHO_OFF */
 
-    size_t len = prv_hist_restore_line(&mrl->ring_hist, mrl->cmdline_str, dir);
-    memset(&mrl->cmdline_str[len], 0x00, MICRORL_ARRAYSIZE(mrl->cmdline_str) - 1 - len);
+    size_t age = prv_hist_navigate(&mrl->ring_hist, dir);
+    size_t len = 0;
+    size_t same = 0;
+
+    if (age != 0) {
+        size_t slot = prv_hist_slot(&mrl->ring_hist, age);
+        same = prv_hist_record_prefix(&mrl->ring_hist, slot, mrl->cmdline_str, mrl->cmdlen);
+        len = prv_hist_copy_record(&mrl->ring_hist, slot, mrl->cmdline_str);
+    }
+    mrl->cmdline_str[len] = '\0';
+
+    prv_terminal_move_cursor(mrl, (int32_t)same - (int32_t)mrl->cursor);
     mrl->cursor = mrl->cmdlen = len;
-    prv_terminal_print_line(mrl, 0, 1);
+    prv_terminal_print_line(mrl, same, 0);
 }
 
 /**
@@ -528,16 +692,14 @@ static void prv_hist_search(microrl_t* mrl, microrl_hist_dir_t dir) {
  * \param[in]       len: Record length
  */
 static void prv_hist_save_line(microrl_hist_rbuf_t* rbuf_ptr, char* line_str, size_t len) {
-    if (len > (MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - 1)) {
+    rbuf_ptr->count = 0;
+
+    if (len == 0 || len > MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
         return;
     }
 
     /* Don't save the same line as the last record */
-    char last_record_str[MICRORL_CFG_CMDLINE_LEN + 1];
-    prv_hist_restore_line(rbuf_ptr, last_record_str,
-                              rbuf_ptr->count == 1 ? MICRORL_HIST_DIR_NONE : MICRORL_HIST_DIR_UP);
-    if (strcmp(line_str, last_record_str) == 0) {
-        rbuf_ptr->count = 0;
+    if (rbuf_ptr->rec_num > 0 && prv_hist_record_equals(rbuf_ptr, prv_hist_slot(rbuf_ptr, 1), line_str, len)) {
         return;
     }
 
@@ -546,22 +708,198 @@ static void prv_hist_save_line(microrl_hist_rbuf_t* rbuf_ptr, char* line_str, si
         prv_hist_erase_older(rbuf_ptr);
     }
 
-    if (len < (MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - rbuf_ptr->tail - 1)) {  /* Store record */
-        memcpy(rbuf_ptr->ring_buf + rbuf_ptr->tail + 1, line_str, len);
+    size_t off = 0;                             /* Records are stored back to back after the newest one */
+    if (rbuf_ptr->rec_num > 0) {
+        size_t last = prv_hist_slot(rbuf_ptr, 1);
+        off = (rbuf_ptr->rec_off[last] + rbuf_ptr->rec_len[last]) % MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf);
     } else {
-        size_t part_len = MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - rbuf_ptr->tail - 1;
-        memcpy(rbuf_ptr->ring_buf + rbuf_ptr->tail + 1, line_str, part_len);
+        rbuf_ptr->rec_first = 0;
+    }
+
+    if ((off + len) <= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {  /* Store record */
+        memcpy(rbuf_ptr->ring_buf + off, line_str, len);
+    } else {
+        size_t part_len = MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf) - off;
+        memcpy(rbuf_ptr->ring_buf + off, line_str, part_len);
         memcpy(rbuf_ptr->ring_buf, line_str + part_len, len - part_len);
     }
 
-    rbuf_ptr->tail = rbuf_ptr->tail + len + 1;  /* Update position pointer and navigation counter */
-    if (rbuf_ptr->tail >= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)) {
-        rbuf_ptr->tail -= MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf);
+    size_t slot = (rbuf_ptr->rec_first + rbuf_ptr->rec_num) % MICRORL_CFG_HISTORY_MAX_RECORDS;
+    rbuf_ptr->rec_off[slot] = (uint16_t)off;    /* Update index */
+    rbuf_ptr->rec_len[slot] = (uint16_t)len;
+#if MICRORL_CFG_USE_HISTORY_SEARCH
+    rbuf_ptr->rec_sig[slot] = prv_hist_sig(line_str, len);
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH */
+    ++rbuf_ptr->rec_num;
+    rbuf_ptr->used += len;
+    ++rbuf_ptr->seq;
+}
+
+#if MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__
+
+/**
+ * \brief           Check if a record contains a string
+ * \param[in]       rbuf_ptr: Pointer to \ref microrl_hist_rbuf_t structure
+ * \param[in]       slot: Index slot of the record
+ * \param[in]       str: String to search for
+ * \param[in]       len: Length of the string
+ * \return          `1` if the string is part of the record, `0` otherwise
+ */
+static uint8_t prv_hist_record_contains(const microrl_hist_rbuf_t* rbuf_ptr, size_t slot, const char* str, size_t len) {
+    size_t off = rbuf_ptr->rec_off[slot];
+    size_t rec_len = rbuf_ptr->rec_len[slot];
+
+    for (size_t start = 0; start + len <= rec_len; ++start) {
+        size_t i = 0;
+        while (i < len && rbuf_ptr->ring_buf[(off + start + i) % MICRORL_ARRAYSIZE(rbuf_ptr->ring_buf)] == str[i]) {
+            ++i;
+        }
+        if (i == len) {
+            return 1;
+        }
     }
-    rbuf_ptr->ring_buf[rbuf_ptr->tail] = 0;
-    rbuf_ptr->count = 0;
+
+    return 0;
+}
+
+/**
+ * \brief           Find the newest record containing the search string
+ * \param[in]       mrl: \ref microrl_t working instance
+ * \param[in]       age: Age of the first record to check, `1` is the newest record
+ * \return          Age of the matching record, `0` if no record matches
+ */
+static size_t prv_hist_search_find(const microrl_t* mrl, size_t age) {
+    const microrl_hist_rbuf_t* rbuf_ptr = &mrl->ring_hist;
+    const microrl_hist_search_t* search = &mrl->hist_search;
+
+    for (; age > 0 && age <= rbuf_ptr->rec_num; ++age) {
+        size_t slot = prv_hist_slot(rbuf_ptr, age);
+        if ((rbuf_ptr->rec_sig[slot] & search->sig) == search->sig   /* Cheap reject by signature */
+            && prv_hist_record_contains(rbuf_ptr, slot, search->str, search->len)) {
+            return age;
+        }
+    }
+
+    return 0;
 }
 
+/**
+ * \brief           Print the search string and the current match in terminal
+ * \param[in]       mrl: \ref microrl_t working instance
+ */
+static void prv_hist_search_print(microrl_t* mrl) {
+    microrl_hist_search_t* search = &mrl->hist_search;
+    char line_str[MICRORL_CFG_CMDLINE_LEN + 1] = {0};
+
+    if (search->age != 0) {
+        prv_hist_copy_record(&mrl->ring_hist, prv_hist_slot(&mrl->ring_hist, search->age), line_str);
+    }
+
+    prv_output(mrl, (search->len > 0 && search->age == 0) ? "\r(failed reverse-i-search)`" : "\r(reverse-i-search)`");
+    prv_output(mrl, search->str);
+    prv_output(mrl, "': ");
+    prv_output(mrl, line_str);
+    prv_output(mrl, "\033[K");
+}
+
+/**
+ * \brief           Leave reverse history search and restore the prompt
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       accept: Copy the current match to the command line if `1`,
+ *                      keep the command line untouched if `0`
+ */
+static void prv_hist_search_stop(microrl_t* mrl, uint8_t accept) {
+    microrl_hist_search_t* search = &mrl->hist_search;
+
+    if (accept && search->age != 0) {
+        size_t len = prv_hist_copy_record(&mrl->ring_hist, prv_hist_slot(&mrl->ring_hist, search->age), mrl->cmdline_str);
+        mrl->cmdline_str[len] = '\0';
+        mrl->cursor = mrl->cmdlen = len;
+        mrl->ring_hist.count = search->age;     /* Up/Down continue from the match */
+    }
+    search->active = 0;
+
+    prv_output(mrl, "\r\033[K");
+    prv_terminal_print_prompt(mrl);
+    prv_terminal_print_line(mrl, 0, 0);
+}
+
+/**
+ * \brief           Start reverse history search
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ */
+static void prv_hist_search_start(microrl_t* mrl) {
+#if MICRORL_CFG_USE_ECHO_OFF
+    if (mrl->echo != MICRORL_ECHO_ON) {
+        return;
+    }
+#endif /* MICRORL_CFG_USE_ECHO_OFF */
+
+    memset(&mrl->hist_search, 0x00, sizeof(mrl->hist_search));
+    mrl->hist_search.active = 1;
+    prv_hist_search_print(mrl);
+}
+
+/**
+ * \brief           Process an input character while reverse history search is active
+ *
+ * Printable characters extend the search string, Ctrl+R steps to the next older match,
+ * Backspace shortens the search string and Ctrl+G or Ctrl+C cancel the search.
+ * Any other control character accepts the match and is then processed as usual.
+ *
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       ch: Input character
+ * \return          `1` if the character is consumed, `0` if it must be processed as usual
+ */
+static uint8_t prv_hist_search_process(microrl_t* mrl, char ch) {
+    microrl_hist_search_t* search = &mrl->hist_search;
+
+    switch (ch) {
+        case MICRORL_ESC_ANSI_DC2: {            /* ^R */
+            if (search->age != 0) {
+                size_t age = prv_hist_search_find(mrl, search->age + 1);
+                if (age != 0) {
+                    search->age = age;
+                }
+            }
+            break;
+        }
+        case MICRORL_ESC_ANSI_BEL:              /* ^G */
+        case MICRORL_ESC_ANSI_ETX: {            /* ^C */
+            prv_hist_search_stop(mrl, 0);
+            return 1;
+        }
+        case MICRORL_ESC_ANSI_DEL:              /* Backspace */
+        case MICRORL_ESC_ANSI_BS: {             /* ^H */
+            if (search->len > 0) {
+                search->str[--search->len] = '\0';
+                search->sig = prv_hist_sig(search->str, search->len);
+                search->age = search->len > 0 ? prv_hist_search_find(mrl, 1) : 0;
+            }
+            break;
+        }
+        default: {
+            if (IS_CONTROL_CHAR(ch)) {
+                prv_hist_search_stop(mrl, 1);
+                return 0;
+            }
+            if (search->len < MICRORL_CFG_HISTORY_SEARCH_LEN) {
+                search->str[search->len++] = ch;
+                search->sig = prv_hist_sig(search->str, search->len);
+
+                /* A longer search string can't match a newer record than the current match */
+                search->age = prv_hist_search_find(mrl, search->age != 0 ? search->age : 1);
+            }
+            break;
+        }
+    }
+
+    prv_hist_search_print(mrl);
+    return 1;
+}
+
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH || __DOXYGEN__ */
+
 #endif /* MICRORL_CFG_USE_HISTORY || __DOXYGEN__ */
 
 #if MICRORL_CFG_USE_ESC_SEQ || __DOXYGEN__
@@ -638,8 +976,10 @@ static uint8_t prv_escape_process(microrl_t* mrl, char ch) {
  * \return          \ref microrlOK on success, member of \ref microrlr_t enumeration otherwise
  */
 static microrlr_t prv_handle_newline(microrl_t* mrl) {
-    const char* tkn_str_arr[MICRORL_CFG_CMD_TOKEN_NMB] = {0};
-    uint8_t tkn_cnt = 0;
+    microrl_token_t tkn_arr[MICRORL_CFG_CMD_TOKEN_NMB];
+    const char* tkn_str_arr[MICRORL_CFG_CMD_TOKEN_NMB + 1];
+    char arg_buf[MICRORL_CFG_CMDLINE_LEN + 1];
+    size_t tkn_cnt = 0;
     microrlr_t status = microrlOK;
 
     prv_terminal_newline(mrl);
@@ -659,28 +999,37 @@ static microrlr_t prv_handle_newline(microrl_t* mrl) {
 #endif /* MICRORL_CFG_USE_HISTORY */
 
 #if MICRORL_CFG_USE_ECHO_OFF
-    if (mrl->echo == MICRORL_ECHO_ONCE && mrl->cmdline_str[mrl->echo_off_pos] != '\0') {
+    if (mrl->echo == MICRORL_ECHO_ONCE && mrl->echo_off_pos >= 0 && (size_t)mrl->echo_off_pos < mrl->cmdlen) {
         microrl_set_echo(mrl, MICRORL_ECHO_ON);
         mrl->echo_off_pos = -1;
     }
 #endif /* MICRORL_CFG_USE_ECHO_OFF */
 
-    status = prv_cmdline_buf_split(mrl, tkn_str_arr, &tkn_cnt, mrl->cmdlen);
-    if (status == microrlOK) {
+    /* Execute the commands of the line one after another, empty commands are skipped */
+    for (size_t pos = 0; pos < mrl->cmdlen; ++pos) {
+        status = prv_cmdline_tokenize(mrl, &pos, mrl->cmdlen, tkn_arr, &tkn_cnt, NULL);
+        if (status != microrlOK) {
+            prv_output(mrl, "ERROR: too many tokens");
+            prv_terminal_newline(mrl);
+            break;
+        }
+        if (tkn_cnt == 0) {
+            continue;
+        }
+
+        prv_cmdline_tokens_to_args(mrl, tkn_arr, tkn_cnt, arg_buf, tkn_str_arr);
+        prv_output_flush(mrl);                  /* Echo and newline go out before the command output */
 #if MICRORL_CFG_USE_COMMAND_HOOKS
         int exec_status = 0;
 
-        MICRORL_PRE_COMMAND_HOOK(mrl, tkn_cnt, tkn_str_arr);
+        MICRORL_PRE_COMMAND_HOOK(mrl, (int)tkn_cnt, tkn_str_arr);
 
-        exec_status = mrl->exec_fn(mrl, tkn_cnt, tkn_str_arr);
+        exec_status = mrl->exec_fn(mrl, (int)tkn_cnt, tkn_str_arr);
 
-        MICRORL_POST_COMMAND_HOOK(mrl, exec_status, tkn_cnt, tkn_str_arr);
+        MICRORL_POST_COMMAND_HOOK(mrl, exec_status, (int)tkn_cnt, tkn_str_arr);
 #else
-        mrl->exec_fn(mrl, tkn_cnt, tkn_str_arr);
+        mrl->exec_fn(mrl, (int)tkn_cnt, tkn_str_arr);
 #endif /* MICRORL_CFG_USE_COMMAND_HOOKS */
-    } else {
-        mrl->out_fn(mrl, "ERROR: too many tokens");
-        prv_terminal_newline(mrl);
     }
 
 exit:
@@ -720,6 +1069,52 @@ static size_t prv_complete_total_len(const char* const * argv) {
     return i;
 }
 
+/**
+ * \brief           Print completion candidates
+ *
+ * Candidates are printed in columns if the terminal width is known,
+ * in one line separated by a space otherwise.
+ *
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       argv: NULL-terminated completion tokens array
+ */
+static void prv_complete_print_list(microrl_t* mrl, const char* const * argv) {
+    static const char spaces[] = "                ";
+    size_t col_width = 0;
+    size_t cols = 0;
+
+    if (mrl->term_width > 0) {
+        for (size_t i = 0; argv[i] != NULL; ++i) {
+            size_t len = strlen(argv[i]);
+            if (len > col_width) {
+                col_width = len;
+            }
+        }
+        col_width += 2;
+        cols = mrl->term_width > col_width ? mrl->term_width / col_width : 1;
+    }
+
+    prv_terminal_newline(mrl);
+    for (size_t i = 0; argv[i] != NULL; ++i) {
+        prv_output(mrl, argv[i]);
+        if (cols == 0) {
+            prv_output(mrl, " ");
+        } else if ((i + 1) % cols == 0 || argv[i + 1] == NULL) {
+            prv_terminal_newline(mrl);
+        } else {
+            /* Pad to the next column */
+            for (size_t pad = col_width - strlen(argv[i]); pad > 0;) {
+                size_t n = pad < sizeof(spaces) - 1 ? pad : sizeof(spaces) - 1;
+                prv_output(mrl, spaces + sizeof(spaces) - 1 - n);
+                pad -= n;
+            }
+        }
+    }
+    if (cols == 0) {
+        prv_terminal_newline(mrl);
+    }
+}
+
 /**
  * \brief           Auto-complete activities to complete input in
  *                      command line
@@ -734,26 +1129,40 @@ static microrlr_t prv_complete_get_input(microrl_t* mrl) {
     }
 #endif /* MICRORL_CFG_USE_ECHO_OFF */
 
-    uint8_t tkn_cnt = 0;
-    const char* tkn_str_arr[MICRORL_CFG_CMD_TOKEN_NMB] = {0};
+    microrl_token_t tkn_arr[MICRORL_CFG_CMD_TOKEN_NMB];
+    const char* tkn_str_arr[MICRORL_CFG_CMD_TOKEN_NMB + 1];
+    char arg_buf[MICRORL_CFG_CMDLINE_LEN + 1];
+    size_t tkn_cnt = 0;
+    char quote = 0;
     char** cmplt_tkn_arr;
+    size_t tkn_pos = 0;
 
-    if (prv_cmdline_buf_split(mrl, tkn_str_arr, &tkn_cnt, mrl->cursor) != microrlOK) {
-        return microrlERRCPLT;
+    /* Complete the command the cursor is in */
+    while (1) {
+        if (prv_cmdline_tokenize(mrl, &tkn_pos, mrl->cursor, tkn_arr, &tkn_cnt, &quote) != microrlOK) {
+            return microrlERRCPLT;
+        }
+        if (tkn_pos >= mrl->cursor) {
+            break;
+        }
+        ++tkn_pos;                              /* Skip the separator */
     }
+    prv_cmdline_tokens_to_args(mrl, tkn_arr, tkn_cnt, arg_buf, tkn_str_arr);
 
-    if (mrl->cmdline_str[mrl->cursor - 1] == '\0') {
-        /* Last char is whitespace */
+    if (tkn_cnt == 0 || (size_t)(tkn_arr[tkn_cnt - 1].off + tkn_arr[tkn_cnt - 1].len) < mrl->cursor) {
+        /* Last char is whitespace or line is empty */
+        if (tkn_cnt >= MICRORL_CFG_CMD_TOKEN_NMB) {
+            return microrlERRCPLT;
+        }
         tkn_str_arr[tkn_cnt++] = "";
         tkn_str_arr[tkn_cnt] = NULL;
     }
 
-    cmplt_tkn_arr = mrl->get_completion_fn(mrl, tkn_cnt, tkn_str_arr);
-    if (cmplt_tkn_arr[0] == NULL) {
+    cmplt_tkn_arr = mrl->get_completion_fn(mrl, (int)tkn_cnt, tkn_str_arr);
+    if (cmplt_tkn_arr == NULL || cmplt_tkn_arr[0] == NULL) {
         return microrlERRCPLT;
     }
 
-    size_t i = 0;
     size_t len;
     size_t pos = mrl->cursor;
 
@@ -761,13 +1170,7 @@ static microrlr_t prv_complete_get_input(microrl_t* mrl) {
         len = strlen(cmplt_tkn_arr[0]);
     } else {
         len = prv_complete_total_len((const char* const *)cmplt_tkn_arr);
-        prv_terminal_newline(mrl);
-        while (cmplt_tkn_arr[i] != NULL) {
-            mrl->out_fn(mrl, cmplt_tkn_arr[i]);
-            mrl->out_fn(mrl, " ");
-            ++i;
-        }
-        prv_terminal_newline(mrl);
+        prv_complete_print_list(mrl, (const char* const *)cmplt_tkn_arr);
         prv_terminal_print_prompt(mrl);
         pos = 0;
     }
@@ -777,16 +1180,12 @@ static microrlr_t prv_complete_get_input(microrl_t* mrl) {
                                     len - strlen(tkn_str_arr[tkn_cnt - 1]));
     }
 
-    /* Insert end space if completion is performed */
+    /* Insert end space if completion is performed, close the quote first */
     if (cmplt_tkn_arr[1] == NULL) {
-        prv_cmdline_buf_insert_text(mrl, " ", 1);
-    }
-
-    /* Restore whitespaces replaced with '0' when command line buffer was split */
-    if (tkn_cnt != 0) {
-        for (size_t i = 0; i < (size_t)(tkn_cnt - 1); ++i) {
-            memset((char*)tkn_str_arr[i] + strlen(tkn_str_arr[i]), ' ', 1);
+        if (quote != 0) {
+            prv_cmdline_buf_insert_text(mrl, &quote, 1);
         }
+        prv_cmdline_buf_insert_text(mrl, " ", 1);
     }
 
     prv_terminal_print_line(mrl, pos, 0);
@@ -812,9 +1211,11 @@ microrlr_t microrl_init(microrl_t* mrl, microrl_output_fn out_fn, microrl_exec_f
     mrl->out_fn = out_fn;
     mrl->exec_fn = exec_fn;
     mrl->prompt_ptr = MICRORL_CFG_PROMPT_STRING;
+    mrl->prompt_len = strlen(mrl->prompt_ptr);
 
 #if MICRORL_CFG_PROMPT_ON_INIT
     prv_terminal_print_prompt(mrl);
+    prv_output_flush(mrl);
 #endif /* MICRORL_CFG_PROMPT_ON_INIT */
 
 #if MICRORL_CFG_USE_ECHO_OFF
@@ -889,6 +1290,26 @@ microrlr_t  microrl_set_prompt(microrl_t* mrl, char* prompt_str) {
     }
 
     mrl->prompt_ptr = prompt_str;
+    mrl->prompt_len = strlen(prompt_str);
+
+    return microrlOK;
+}
+
+/**
+ * \brief           Set the width of the terminal
+ *
+ * The line editor uses the width to lay out completion candidates in columns.
+ *
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       width: Number of columns, `0` if unknown
+ * \return          \ref microrlOK on success, member of \ref microrlr_t enumeration otherwise
+ */
+microrlr_t  microrl_set_term_width(microrl_t* mrl, uint16_t width) {
+    if (mrl == NULL) {
+        return microrlERRPAR;
+    }
+
+    mrl->term_width = width;
 
     return microrlOK;
 }
@@ -942,14 +1363,16 @@ static microrlr_t prv_control_char_process(microrl_t* mrl, char ch) {
         }
         case MICRORL_ESC_ANSI_NAK: { /* ^U */
             if (mrl->cursor > 0) {
+                prv_terminal_move_cursor(mrl, -(int32_t)mrl->cursor);
                 prv_cmdline_buf_backspace(mrl, mrl->cursor);
+                prv_terminal_print_line(mrl, 0, 0);
             }
-            prv_terminal_print_line(mrl, 0, 1);
             break;
         }
         case MICRORL_ESC_ANSI_VT: { /* ^K */
-            mrl->out_fn(mrl, "\033[K");
+            prv_output(mrl, "\033[K");
             mrl->cmdlen = mrl->cursor;
+            mrl->cmdline_str[mrl->cmdlen] = '\0';
             break;
         }
         case MICRORL_ESC_ANSI_ENQ: { /* ^E */
@@ -995,7 +1418,8 @@ static microrlr_t prv_control_char_process(microrl_t* mrl, char ch) {
                 if (mrl->cursor == mrl->cmdlen) {
                     prv_terminal_backspace(mrl);
                 } else {
-                    prv_terminal_print_line(mrl, mrl->cursor, 1);
+                    prv_terminal_move_cursor(mrl, -1);
+                    prv_terminal_print_line(mrl, mrl->cursor, 0);
                 }
             }
             break;
@@ -1006,9 +1430,13 @@ static microrlr_t prv_control_char_process(microrl_t* mrl, char ch) {
             break;
         }
         case MICRORL_ESC_ANSI_DC2: { /* ^R */
+#if MICRORL_CFG_USE_HISTORY_SEARCH
+            prv_hist_search_start(mrl);
+#else
             prv_terminal_newline(mrl);
             prv_terminal_print_prompt(mrl);
             prv_terminal_print_line(mrl, 0, 0);
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH */
             break;
         }
         case MICRORL_ESC_ANSI_ETX: {
@@ -1016,6 +1444,7 @@ static microrlr_t prv_control_char_process(microrl_t* mrl, char ch) {
             if (mrl->sigint_fn == NULL) {
                 return microrlERRPAR;
             }
+            prv_output_flush(mrl);
             mrl->sigint_fn(mrl);
 #endif /* MICRORL_CFG_USE_CTRL_C */
             break;
@@ -1045,7 +1474,7 @@ static microrlr_t prv_insert_char(microrl_t* mrl, char ch) {
             nch[0] = MICRORL_CFG_ECHO_OFF_MASK;
         }
 #endif /* MICRORL_CFG_USE_ECHO_OFF */
-        mrl->out_fn(mrl, nch);
+        prv_output(mrl, nch);
     } else {
         prv_terminal_print_line(mrl, mrl->cursor - 1, 0);
     }
@@ -1066,6 +1495,7 @@ microrlr_t microrl_processing_input(microrl_t* mrl, const void* data_ptr, size_t
     }
 
     char* buf_ptr = (char*)data_ptr;
+    microrlr_t status = microrlOK;
 
     while (len-- != 0) {
         char ch = *buf_ptr++;
@@ -1079,6 +1509,13 @@ microrlr_t microrl_processing_input(microrl_t* mrl, const void* data_ptr, size_t
         }
 #endif /* MICRORL_CFG_USE_ESC_SEQ */
 
+#if MICRORL_CFG_USE_HISTORY_SEARCH
+        if (mrl->hist_search.active && prv_hist_search_process(mrl, ch)) {
+            mrl->last_endl = 0;
+            continue;
+        }
+#endif /* MICRORL_CFG_USE_HISTORY_SEARCH */
+
         if ((ch == MICRORL_ESC_ANSI_CR) || (ch == MICRORL_ESC_ANSI_LF)) {
             /*
              * Only trigger a newline if `ch` doen't follow its companion's
@@ -1088,8 +1525,8 @@ microrlr_t microrl_processing_input(microrl_t* mrl, const void* data_ptr, size_t
                 mrl->last_endl = 0;             /* Ignore char, but clear newline state */
             } else {
                 mrl->last_endl = ch;
-                if (prv_handle_newline(mrl) != microrlOK) {
-                    return microrlERRTKNNUM;
+                if (prv_handle_newline(mrl) != microrlOK && status == microrlOK) {
+                    status = microrlERRTKNNUM;  /* Keep processing the rest of the input */
                 }
             }
             continue;
@@ -1101,18 +1538,84 @@ microrlr_t microrl_processing_input(microrl_t* mrl, const void* data_ptr, size_t
             res = prv_control_char_process(mrl, ch);
         } else {
             if ((ch == ' ') && (mrl->cmdlen == 0)) {    /* Skip spaces before first command line symbol */
-                break;
+                continue;
             }
             res = prv_insert_char(mrl, ch);
         }
-        if (res != microrlOK) {
-            return res;
+        if (res != microrlOK && status == microrlOK) {
+            status = res;                       /* Report first error, but process the rest of the input */
         }
     }
 
+    prv_output_flush(mrl);
+
+    return status;
+}
+
+#if MICRORL_CFG_USE_HISTORY || __DOXYGEN__
+/**
+ * \brief           Add a record to the history, e.g. to restore it from persistent storage.
+ *                      The record becomes the newest one, the oldest records are dropped if necessary
+ * \param[in,out]   mrl: \ref microrl_t working instance
+ * \param[in]       line_str: Record to add, not NULL terminated
+ * \param[in]       len: Length of the record, at most \ref MICRORL_CFG_CMDLINE_LEN
+ * \return          \ref microrlOK on success, member of \ref microrlr_t enumeration otherwise
+ */
+microrlr_t microrl_hist_add(microrl_t* mrl, const char* line_str, size_t len) {
+    if (mrl == NULL || line_str == NULL || len == 0 || len > MICRORL_CFG_CMDLINE_LEN) {
+        return microrlERRPAR;
+    }
+
+    prv_hist_save_line(&mrl->ring_hist, (char*)line_str, len);
+
     return microrlOK;
 }
 
+/**
+ * \brief           Copy a history record to a buffer
+ * \param[in]       mrl: \ref microrl_t working instance
+ * \param[in]       age: Age of the record, `1` is the newest record
+ * \param[out]      buf: Buffer for the NULL terminated record
+ * \param[in]       size: Size of the buffer, at least \ref MICRORL_CFG_CMDLINE_LEN + 1
+ * \return          Length of the record, `0` if there is no such record or the buffer is too small
+ */
+size_t microrl_hist_get(const microrl_t* mrl, size_t age, char* buf, size_t size) {
+    if (mrl == NULL || buf == NULL || age == 0 || age > mrl->ring_hist.rec_num) {
+        return 0;
+    }
+
+    size_t slot = prv_hist_slot(&mrl->ring_hist, age);
+    if (size <= mrl->ring_hist.rec_len[slot]) {
+        return 0;
+    }
+
+    size_t len = prv_hist_copy_record(&mrl->ring_hist, slot, buf);
+    buf[len] = '\0';
+
+    return len;
+}
+
+/**
+ * \brief           Get number of records in the history
+ * \param[in]       mrl: \ref microrl_t working instance
+ * \return          Number of records
+ */
+size_t microrl_hist_records(const microrl_t* mrl) {
+    return mrl != NULL ? mrl->ring_hist.rec_num : 0;
+}
+
+/**
+ * \brief           Get number of records saved to the history since initialization.
+ *                      Compare two values to find out how many records are new, e.g. to
+ *                      write them to persistent storage in batches
+ * \param[in]       mrl: \ref microrl_t working instance
+ * \return          Number of saved records, wraps around
+ */
+uint32_t microrl_hist_seq(const microrl_t* mrl) {
+    return mrl != NULL ? mrl->ring_hist.seq : 0;
+}
+#endif /* MICRORL_CFG_USE_HISTORY || __DOXYGEN__ */
+
 /**
  * \brief           Get current version number of the MicroRL library.
  *                      Semantic versioning is used for numbering